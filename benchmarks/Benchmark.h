@@ -0,0 +1,356 @@
+/******************************************************************/
+/*!
+	@file	Benchmark.h
+	@brief	Minimal benchmark harness
+	@note	Every case runs warmup repetitions which are discarded,
+			then measured repetitions. The time per operation is
+			reported as median and percentiles over repetitions,
+			per-operation samples (latency) as percentiles over
+			all samples. Results can be written as JSON.
+	@todo
+	@bug
+
+	@author	Naoto Nakamura
+	@date	Oct. 18, 2026
+*/
+/******************************************************************/
+
+#ifndef STHREAD_BENCHMARK_H
+#define STHREAD_BENCHMARK_H
+
+#include "SThread/SThread.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <thread>
+
+
+namespace SThreadBenchmark{
+    //////////////////////////////////////////////////
+    //				forward declarations			//
+    //////////////////////////////////////////////////
+    //implemented
+    class BenchmarkState;
+    class BenchmarkRunner;
+    class FunctionThread;
+
+    //////////////////////////////////////////////////
+    //				class declarations				//
+    //////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @class	BenchmarkState
+        @brief	State of one repetition
+        @note	The case does its setup, calls begin(), runs
+                getNumOp() operations and calls end(). Setup
+                outside begin()/end() is not measured.
+    */
+    /****************************************/
+    class BenchmarkState
+    {
+    public:
+        explicit BenchmarkState(unsigned long long numOp)
+        :mNumOp(numOp), mBeginTime(0), mEndTime(0){}
+
+    public:
+        unsigned long long getNumOp() const {return mNumOp;}
+
+        void begin(){mBeginTime = SThread::Timer::getMonotonicNanoTime();}
+        void end(){mEndTime = SThread::Timer::getMonotonicNanoTime();}
+
+        //! Latency of one operation
+        void addSample(unsigned long long nanoSec){mSamples.push_back(nanoSec);}
+
+        void skip(const std::string &reason){mSkipReason = reason;}
+
+        bool isSkipped() const {return !mSkipReason.empty();}
+        const std::string &getSkipReason() const {return mSkipReason;}
+
+        unsigned long long getElapsedNanoTime() const {
+            return mEndTime > mBeginTime ? mEndTime - mBeginTime : 0;
+        }
+        std::vector<unsigned long long> &getSamples(){return mSamples;}
+
+    private:
+        unsigned long long mNumOp;
+        unsigned long long mBeginTime;
+        unsigned long long mEndTime;
+
+        std::vector<unsigned long long> mSamples;
+        std::string mSkipReason;
+    };
+
+    typedef std::function<void(BenchmarkState &state)> BenchmarkFunction;
+
+    /****************************************/
+    /*!
+        @class	FunctionThread
+        @brief	Thread running a function object
+    */
+    /****************************************/
+    class FunctionThread : public SThread::Thread
+    {
+    public:
+        explicit FunctionThread(const std::function<void()> &function)
+        :SThread::Thread(), mFunction(function){}
+
+    protected:
+        virtual void run(){mFunction();}
+
+    private:
+        std::function<void()> mFunction;
+    };
+
+    /****************************************/
+    /*!
+        @class	BenchmarkRunner
+        @brief	Registry and driver of the cases
+        @note	Options
+                --filter=<text>     run cases whose name contains text
+                --warmup=<n>        discarded repetitions (default 2)
+                --repetitions=<n>   measured repetitions (default 10)
+                --json[=<file>]     JSON to the file, or to stdout
+                                    instead of the table
+                --list              print case names
+    */
+    /****************************************/
+    class BenchmarkRunner
+    {
+    public:
+        static const int DEFAULT_WARMUP = 2;
+        static const int DEFAULT_REPETITIONS = 10;
+
+    private:
+        struct BenchmarkCase
+        {
+            std::string name;
+            unsigned long long numOp;
+            BenchmarkFunction function;
+        };
+
+        struct BenchmarkResult
+        {
+            std::string name;
+            unsigned long long numOp;
+            std::string skipReason;
+
+            std::vector<double> nanoPerOp;				//!< One per measured repetition, sorted
+            std::vector<unsigned long long> samples;	//!< All measured samples, sorted
+        };
+
+    public:
+        BenchmarkRunner()
+        :mWarmup(DEFAULT_WARMUP), mRepetitions(DEFAULT_REPETITIONS), mIsJson(FALSE), mIsList(FALSE){}
+
+    public:
+        void add(const std::string &name, unsigned long long numOp, const BenchmarkFunction &function)
+        {
+            BenchmarkCase benchCase;
+            benchCase.name = name;
+            benchCase.numOp = numOp;
+            benchCase.function = function;
+            mCases.push_back(benchCase);
+        }
+
+        //! Number of hardware threads, at least 1
+        static int getNumCore()
+        {
+            int numCore = (int)std::thread::hardware_concurrency();
+            return numCore > 0 ? numCore : 1;
+        }
+
+        int run(int argc, char **argv)
+        {
+            if(!parse(argc, argv)) return 1;
+
+            if(mIsList){
+                for(size_t i = 0; i < mCases.size(); i++) printf("%s\n", mCases[i].name.c_str());
+                return 0;
+            }
+
+            bool isTable = !(mIsJson && mJsonPath.empty());
+            if(isTable){
+                printf("%d cores, %d warmup, %d repetitions, time per operation in ns\n", getNumCore(), mWarmup, mRepetitions);
+                printf("%-64s %10s %10s %10s %7s %12s   %s\n", "name", "median", "min", "p90", "cv", "ops/s", "latency p50/p99/p999 (ns)");
+            }
+
+            std::vector<BenchmarkResult> results;
+            for(size_t i = 0; i < mCases.size(); i++){
+                if(!mFilter.empty() && mCases[i].name.find(mFilter) == std::string::npos) continue;
+
+                BenchmarkResult result = runCase(mCases[i]);
+                if(isTable) printResult(result);
+                results.push_back(result);
+            }
+
+            if(mIsJson){
+                FILE *fp = mJsonPath.empty() ? stdout : fopen(mJsonPath.c_str(), "w");
+                if(fp == NULL){
+                    fprintf(stderr, "cannot open %s\n", mJsonPath.c_str());
+                    return 1;
+                }
+                writeJson(fp, results);
+                if(fp != stdout) fclose(fp);
+            }
+            return 0;
+        }
+
+    private:
+        bool parse(int argc, char **argv)
+        {
+            for(int i = 1; i < argc; i++){
+                const char *arg = argv[i];
+                if(strncmp(arg, "--filter=", 9) == 0) mFilter = arg + 9;
+                else if(strncmp(arg, "--warmup=", 9) == 0) mWarmup = atoi(arg + 9);
+                else if(strncmp(arg, "--repetitions=", 14) == 0) mRepetitions = atoi(arg + 14);
+                else if(strcmp(arg, "--json") == 0) mIsJson = TRUE;
+                else if(strncmp(arg, "--json=", 7) == 0){
+                    mIsJson = TRUE;
+                    mJsonPath = arg + 7;
+                }
+                else if(strcmp(arg, "--list") == 0) mIsList = TRUE;
+                else{
+                    fprintf(stderr, "usage: %s [--filter=<text>] [--warmup=<n>] [--repetitions=<n>] [--json[=<file>]] [--list]\n", argv[0]);
+                    return FALSE;
+                }
+            }
+            if(mWarmup < 0) mWarmup = 0;
+            if(mRepetitions < 1) mRepetitions = 1;
+            return TRUE;
+        }
+
+        BenchmarkResult runCase(BenchmarkCase &benchCase)
+        {
+            BenchmarkResult result;
+            result.name = benchCase.name;
+            result.numOp = benchCase.numOp;
+
+            for(int i = 0; i < mWarmup + mRepetitions; i++){
+                BenchmarkState state(benchCase.numOp);
+                benchCase.function(state);
+
+                if(state.isSkipped()){
+                    result.skipReason = state.getSkipReason();
+                    break;
+                }
+                if(i < mWarmup) continue;
+
+                result.nanoPerOp.push_back((double)state.getElapsedNanoTime() / (double)benchCase.numOp);
+                result.samples.insert(result.samples.end(), state.getSamples().begin(), state.getSamples().end());
+            }
+
+            std::stable_sort(result.nanoPerOp.begin(), result.nanoPerOp.end());
+            std::stable_sort(result.samples.begin(), result.samples.end());
+            return result;
+        }
+
+        //! Nearest-rank percentile of a sorted vector
+        template <typename T>
+        static T percentile(const std::vector<T> &sorted, double ratio)
+        {
+            if(sorted.empty()) return T();
+            size_t rank = (size_t)ceil(ratio * (double)sorted.size());
+            if(rank > 0) rank--;
+            if(rank >= sorted.size()) rank = sorted.size() - 1;
+            return sorted[rank];
+        }
+
+        static double mean(const std::vector<double> &values)
+        {
+            double sum = 0.0;
+            for(size_t i = 0; i < values.size(); i++) sum += values[i];
+            return values.empty() ? 0.0 : sum / (double)values.size();
+        }
+
+        //! Coefficient of variation, the run is noisy when it is large
+        static double variation(const std::vector<double> &values)
+        {
+            double average = mean(values);
+            if(values.size() < 2 || average <= 0.0) return 0.0;
+
+            double sum = 0.0;
+            for(size_t i = 0; i < values.size(); i++) sum += (values[i] - average) * (values[i] - average);
+            return sqrt(sum / (double)(values.size() - 1)) / average;
+        }
+
+        void printResult(const BenchmarkResult &result)
+        {
+            if(!result.skipReason.empty()){
+                printf("%-64s skipped (%s)\n", result.name.c_str(), result.skipReason.c_str());
+                return;
+            }
+
+            double median = percentile(result.nanoPerOp, 0.5);
+            printf("%-64s %10.1f %10.1f %10.1f %6.1f%% %12.0f", result.name.c_str(),
+                   median,
+                   result.nanoPerOp.front(),
+                   percentile(result.nanoPerOp, 0.9),
+                   variation(result.nanoPerOp) * 100.0,
+                   median > 0.0 ? 1e9 / median : 0.0);
+
+            if(!result.samples.empty()){
+                printf("   %llu/%llu/%llu",
+                       percentile(result.samples, 0.5),
+                       percentile(result.samples, 0.99),
+                       percentile(result.samples, 0.999));
+            }
+            printf("\n");
+            fflush(stdout);
+        }
+
+        void writeJson(FILE *fp, const std::vector<BenchmarkResult> &results)
+        {
+            fprintf(fp, "{\n  \"context\": {\"cores\": %d, \"warmup\": %d, \"repetitions\": %d},\n", getNumCore(), mWarmup, mRepetitions);
+            fprintf(fp, "  \"benchmarks\": [");
+
+            for(size_t i = 0; i < results.size(); i++){
+                const BenchmarkResult &result = results[i];
+                fprintf(fp, "%s\n    {\"name\": \"%s\", \"ops\": %llu", i == 0 ? "" : ",", result.name.c_str(), result.numOp);
+
+                if(!result.skipReason.empty()){
+                    fprintf(fp, ", \"skipped\": \"%s\"}", result.skipReason.c_str());
+                    continue;
+                }
+
+                double median = percentile(result.nanoPerOp, 0.5);
+                fprintf(fp, ", \"repetitions\": %u", (unsigned int)result.nanoPerOp.size());
+                fprintf(fp, ", \"ns_per_op\": {\"min\": %.3f, \"median\": %.3f, \"mean\": %.3f, \"p90\": %.3f, \"max\": %.3f, \"cv\": %.5f}",
+                        result.nanoPerOp.front(), median, mean(result.nanoPerOp),
+                        percentile(result.nanoPerOp, 0.9), result.nanoPerOp.back(), variation(result.nanoPerOp));
+                fprintf(fp, ", \"ops_per_sec\": %.1f", median > 0.0 ? 1e9 / median : 0.0);
+
+                if(!result.samples.empty()){
+                    fprintf(fp, ", \"latency_ns\": {\"count\": %u, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu}",
+                            (unsigned int)result.samples.size(),
+                            percentile(result.samples, 0.5), percentile(result.samples, 0.9),
+                            percentile(result.samples, 0.99), percentile(result.samples, 0.999),
+                            result.samples.back());
+                }
+                fprintf(fp, "}");
+            }
+            fprintf(fp, "\n  ]\n}\n");
+        }
+
+    private:
+        std::vector<BenchmarkCase> mCases;
+
+        std::string mFilter;
+        int mWarmup;
+        int mRepetitions;
+
+        bool mIsJson;
+        std::string mJsonPath;
+        bool mIsList;
+    };
+
+}; //namespace SThreadBenchmark
+
+
+#endif //STHREAD_BENCHMARK_H
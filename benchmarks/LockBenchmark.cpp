@@ -0,0 +1,114 @@
+#include "Benchmark.h"
+
+using namespace SThread;
+
+namespace SThreadBenchmark{
+
+    static const unsigned long long NUM_LOCK = 1 << 20;
+    static const unsigned long long NUM_PINGPONG = 1 << 14;
+
+    /****************************************/
+    /*!
+        @brief	Lock/unlock pairs on one lock
+        @note	numOp pairs in total, split over the threads
+    */
+    /****************************************/
+    template <class LOCK>
+    static void lockContention(BenchmarkState &state, const int numThread)
+    {
+        if(numThread > BenchmarkRunner::getNumCore()){
+            state.skip("more threads than cores");
+            return;
+        }
+
+        LOCK locker;
+        long counter = 0;
+        std::atomic<bool> isGo(FALSE);
+        unsigned long long numLock = state.getNumOp() / numThread;
+
+        std::vector<FunctionThread*> threads;
+        for(int i = 0; i < numThread; i++){
+            FunctionThread *thread = new FunctionThread([&locker, &counter, &isGo, numLock](){
+                while(!isGo.load()) CPU_PAUSE();
+
+                for(unsigned long long n = 0; n < numLock; n++){
+                    locker.lock();
+                    counter++;
+                    locker.unlock();
+                }
+            });
+            thread->init();
+            thread->start();
+            threads.push_back(thread);
+        }
+
+        state.begin();
+        isGo.store(TRUE);
+        for(size_t i = 0; i < threads.size(); i++) threads[i]->join();
+        state.end();
+
+        for(size_t i = 0; i < threads.size(); i++){
+            threads[i]->cleanup();
+            delete threads[i];
+        }
+    }
+
+    /****************************************/
+    /*!
+        @brief	Condition round trip between two threads
+        @note	One operation is signal -> wake -> signal back
+    */
+    /****************************************/
+    static void conditionPingPong(BenchmarkState &state)
+    {
+        Condition condition;
+        int turn = 0;
+        unsigned long long numRound = state.getNumOp();
+
+        FunctionThread partner([&condition, &turn, numRound](){
+            condition.lock();
+            for(unsigned long long n = 0; n < numRound; n++){
+                while(turn != 1) condition.wait();
+                turn = 0;
+                condition.signalAll();
+            }
+            condition.unlock();
+        });
+        partner.init();
+        partner.start();
+
+        state.begin();
+        condition.lock();
+        for(unsigned long long n = 0; n < numRound; n++){
+            unsigned long long begin = Timer::now();
+            turn = 1;
+            condition.signalAll();
+            while(turn != 0) condition.wait();
+            state.addSample(Timer::now() - begin);
+        }
+        condition.unlock();
+        state.end();
+
+        partner.join();
+        partner.cleanup();
+    }
+
+    void registerLockBenchmarks(BenchmarkRunner &runner)
+    {
+        const int numThreads[] = {1, 2, 4, 8, 16, 32};
+
+        for(size_t i = 0; i < NUM_ARRAY(numThreads); i++){
+            int numThread = numThreads[i];
+            std::string suffix = "/threads:" + std::to_string(numThread);
+
+            runner.add("lock/Mutex" + suffix, NUM_LOCK, [numThread](BenchmarkState &state){lockContention<Mutex>(state, numThread);});
+            runner.add("lock/SpinLock" + suffix, NUM_LOCK, [numThread](BenchmarkState &state){lockContention<SpinLock>(state, numThread);});
+            runner.add("lock/BackoffSpinLock" + suffix, NUM_LOCK, [numThread](BenchmarkState &state){lockContention<BackoffSpinLock>(state, numThread);});
+            runner.add("lock/TicketSpinLock" + suffix, NUM_LOCK, [numThread](BenchmarkState &state){lockContention<TicketSpinLock>(state, numThread);});
+            runner.add("lock/MCSLock" + suffix, NUM_LOCK, [numThread](BenchmarkState &state){lockContention<MCSLock>(state, numThread);});
+        }
+
+        runner.add("condition/pingpong", NUM_PINGPONG, conditionPingPong);
+    }
+
+}; //namespace SThreadBenchmark
@@ -0,0 +1,293 @@
+#include "Benchmark.h"
+
+using namespace SThread;
+
+namespace SThreadBenchmark{
+
+    static const unsigned long long NUM_REQUEST = 1 << 18;
+    static const unsigned long long NUM_LATENCY = 1 << 13;
+    static const unsigned long long NUM_CONTAINER_OP = 1 << 20;
+    static const int CONTAINER_BATCH = 1024;
+
+    enum ContainerType{
+        CONTAINER_QUEUE,
+        CONTAINER_WORKER,
+        CONTAINER_PRIORITY_BUCKET,
+        CONTAINER_MPSC,
+    };
+
+    static const char *CONTAINER_NAMES[] = {
+        "QueueRequestContainer",
+        "WorkerRequestContainer",
+        "PriorityBucketRequestContainer",
+        "MPSCRequestContainer",
+    };
+
+    //! How the throughput producers make their requests
+    enum RequestSource{
+        REQUEST_NEW,		//!< new CountRequest
+        REQUEST_POOLED,		//!< WorkRequest::create<CountRequest>
+        REQUEST_POST,		//!< QueueThread::post of a lambda
+    };
+
+    static RequestContainer *createContainer(ContainerType type)
+    {
+        RequestContainer *container = NULL;
+        switch(type){
+            case CONTAINER_QUEUE: container = new QueueRequestContainer(); break;
+            case CONTAINER_WORKER: container = new WorkerRequestContainer(); break;
+            case CONTAINER_PRIORITY_BUCKET: container = new PriorityBucketRequestContainer(); break;
+            case CONTAINER_MPSC: container = new MPSCRequestContainer(CONTAINER_BATCH * 4); break;
+        }
+        container->init();
+        return container;
+    }
+
+    class CountRequest : public WorkRequest
+    {
+    public:
+        CountRequest(std::atomic<unsigned long long> *numDone, int priority)
+        :WorkRequest(priority, TRUE), mNumDone(numDone){}
+
+    private:
+        virtual bool work(){
+            mNumDone->fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        std::atomic<unsigned long long> *mNumDone;
+    };
+
+    //! Stores enqueue -> execute time
+    class LatencyRequest : public WorkRequest
+    {
+    public:
+        LatencyRequest(unsigned long long enqueueTime, std::atomic<unsigned long long> *latency)
+        :WorkRequest(PRIORITY_NORMAL, TRUE), mEnqueueTime(enqueueTime), mLatency(latency){}
+
+    private:
+        virtual bool work(){
+            mLatency->store(Timer::now() - mEnqueueTime + 1, std::memory_order_release);
+            return true;
+        }
+
+        unsigned long long mEnqueueTime;
+        std::atomic<unsigned long long> *mLatency;
+    };
+
+    class DummyRequest : public WorkRequest
+    {
+    public:
+        explicit DummyRequest(int priority):WorkRequest(priority, FALSE){}
+
+    private:
+        virtual bool work(){return true;}
+    };
+
+    /****************************************/
+    /*!
+        @brief	Enqueue -> execute throughput
+        @note	Producers add auto-deleted requests to one
+                QueueThread, the time ends when all are done.
+    */
+    /****************************************/
+    static void queueThroughput(BenchmarkState &state, ContainerType type, const int numProducer, const bool isStatisticsEnabled = FALSE, const RequestSource source = REQUEST_NEW)
+    {
+        if(numProducer >= BenchmarkRunner::getNumCore() && numProducer > 1){
+            state.skip("more threads than cores");
+            return;
+        }
+
+        std::atomic<unsigned long long> numDone(0);
+        std::atomic<bool> isGo(FALSE);
+
+        QueueThread consumer(createContainer(type));
+        consumer.init();
+        consumer.setStatisticsEnabled(isStatisticsEnabled);
+        consumer.start();
+
+        unsigned long long numRequest = state.getNumOp() / numProducer;
+        std::vector<FunctionThread*> producers;
+        for(size_t i = 0; i < (size_t)numProducer; i++){
+            FunctionThread *producer = new FunctionThread([&consumer, &numDone, &isGo, numRequest, source, i](){
+                while(!isGo.load()) CPU_PAUSE();
+
+                unsigned int seed = (unsigned int)i * 2654435761u + 1;
+                for(unsigned long long n = 0; n < numRequest; n++){
+                    seed ^= seed << 13;
+                    seed ^= seed >> 17;
+                    seed ^= seed << 5;
+
+                    int priority = WorkRequest::PRIORITY_LOW + (int)(seed & 0x1fffffff);
+                    if(source == REQUEST_POST){
+                        while(!consumer.post([&numDone](){numDone.fetch_add(1, std::memory_order_relaxed);}, priority)) std::this_thread::yield();
+                        continue;
+                    }
+
+                    WorkRequest *req = source == REQUEST_POOLED ? WorkRequest::create<CountRequest>(&numDone, priority) : new CountRequest(&numDone, priority);
+                    while(!consumer.addRequest(req)) std::this_thread::yield();
+                }
+            });
+            producer->init();
+            producer->start();
+            producers.push_back(producer);
+        }
+
+        state.begin();
+        isGo.store(TRUE);
+        for(size_t i = 0; i < producers.size(); i++) producers[i]->join();
+        while(numDone.load(std::memory_order_acquire) < numRequest * numProducer) std::this_thread::yield();
+        state.end();
+
+        for(size_t i = 0; i < producers.size(); i++){
+            producers[i]->cleanup();
+            delete producers[i];
+        }
+        consumer.shutdown();
+        consumer.cleanup();
+    }
+
+    /****************************************/
+    /*!
+        @brief	Enqueue -> execute latency of single requests
+        @note	The next request is added after the previous
+                one ran, so the consumer is idle in between.
+    */
+    /****************************************/
+    static void queueLatency(BenchmarkState &state, QueueThread::IdlePolicy policy)
+    {
+        std::atomic<unsigned long long> latency(0);
+
+        QueueThread consumer;
+        consumer.init();
+        consumer.setIdlePolicy(policy);
+        consumer.start();
+
+        state.begin();
+        for(unsigned long long n = 0; n < state.getNumOp(); n++){
+            latency.store(0, std::memory_order_relaxed);
+            consumer.addRequest(new LatencyRequest(Timer::now(), &latency));
+
+            unsigned long long result;
+            while((result = latency.load(std::memory_order_acquire)) == 0) std::this_thread::yield();
+            state.addSample(result - 1);
+        }
+        state.end();
+
+        consumer.shutdown();
+        consumer.cleanup();
+    }
+
+    /****************************************/
+    /*!
+        @brief	submit -> Future::get round trip
+        @note	Samples are the full round trip seen by the caller.
+    */
+    /****************************************/
+    static void submitRoundTrip(BenchmarkState &state, QueueThread::IdlePolicy policy)
+    {
+        QueueThread consumer;
+        consumer.init();
+        consumer.setIdlePolicy(policy);
+        consumer.start();
+
+        unsigned long long check = 0;
+        state.begin();
+        for(unsigned long long n = 0; n < state.getNumOp(); n++){
+            unsigned long long begin = Timer::now();
+            Future<unsigned long long> future = consumer.submit([n](){return n;});
+            check += future.get() == n;
+            state.addSample(Timer::now() - begin);
+        }
+        state.end();
+
+        if(check != state.getNumOp()) state.skip("wrong future value");
+
+        consumer.shutdown();
+        consumer.cleanup();
+    }
+
+    /****************************************/
+    /*!
+        @brief	Container add + pop on one thread
+        @note	One operation is one add and one pop,
+                CONTAINER_BATCH requests are queued at a time.
+    */
+    /****************************************/
+    static void containerOperation(BenchmarkState &state, ContainerType type)
+    {
+        RequestContainer *container = createContainer(type);
+
+        std::vector<DummyRequest*> requests;
+        unsigned int seed = 1;
+        for(int i = 0; i < CONTAINER_BATCH; i++){
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            requests.push_back(new DummyRequest(WorkRequest::PRIORITY_LOW + (int)(seed & 0x1fffffff)));
+        }
+
+        unsigned long long numBatch = state.getNumOp() / CONTAINER_BATCH;
+        unsigned long long check = 0;
+
+        state.begin();
+        for(unsigned long long n = 0; n < numBatch; n++){
+            for(int i = 0; i < CONTAINER_BATCH; i++) container->add(requests[i]);
+            for(int i = 0; i < CONTAINER_BATCH; i++) check += (container->pop() != NULL);
+        }
+        state.end();
+
+        if(check != numBatch * CONTAINER_BATCH) state.skip("container lost requests");
+
+        container->cleanup();
+        delete container;
+        for(size_t i = 0; i < requests.size(); i++) delete requests[i];
+    }
+
+    void registerQueueBenchmarks(BenchmarkRunner &runner)
+    {
+        const ContainerType types[] = {CONTAINER_QUEUE, CONTAINER_WORKER, CONTAINER_PRIORITY_BUCKET, CONTAINER_MPSC};
+        const int numProducers[] = {1, 4};
+
+        for(size_t p = 0; p < NUM_ARRAY(numProducers); p++){
+            for(size_t t = 0; t < NUM_ARRAY(types); t++){
+                ContainerType type = types[t];
+                int numProducer = numProducers[p];
+                runner.add(std::string("queuethread/throughput/") + CONTAINER_NAMES[type] + "/producers:" + std::to_string(numProducer), NUM_REQUEST,
+                           [type, numProducer](BenchmarkState &state){queueThroughput(state, type, numProducer);});
+            }
+        }
+
+        //cost of the wait/service histograms
+        for(size_t t = 0; t < NUM_ARRAY(types); t++){
+            ContainerType type = types[t];
+            runner.add(std::string("queuethread/throughput/") + CONTAINER_NAMES[type] + "/producers:1/statistics", NUM_REQUEST,
+                       [type](BenchmarkState &state){queueThroughput(state, type, 1, TRUE);});
+        }
+
+        //requests from WorkRequest::create and post instead of new
+        for(size_t p = 0; p < NUM_ARRAY(numProducers); p++){
+            int numProducer = numProducers[p];
+            runner.add(std::string("queuethread/throughput/") + CONTAINER_NAMES[CONTAINER_MPSC] + "/producers:" + std::to_string(numProducer) + "/pooled", NUM_REQUEST,
+                       [numProducer](BenchmarkState &state){queueThroughput(state, CONTAINER_MPSC, numProducer, FALSE, REQUEST_POOLED);});
+            runner.add(std::string("queuethread/throughput/") + CONTAINER_NAMES[CONTAINER_MPSC] + "/producers:" + std::to_string(numProducer) + "/post", NUM_REQUEST,
+                       [numProducer](BenchmarkState &state){queueThroughput(state, CONTAINER_MPSC, numProducer, FALSE, REQUEST_POST);});
+        }
+
+        runner.add("queuethread/latency/IDLE_PARK", NUM_LATENCY,
+                   [](BenchmarkState &state){queueLatency(state, QueueThread::IDLE_PARK);});
+        runner.add("queuethread/latency/IDLE_SPIN_THEN_PARK", NUM_LATENCY,
+                   [](BenchmarkState &state){queueLatency(state, QueueThread::IDLE_SPIN_THEN_PARK);});
+        runner.add("queuethread/submit/IDLE_PARK", NUM_LATENCY,
+                   [](BenchmarkState &state){submitRoundTrip(state, QueueThread::IDLE_PARK);});
+        runner.add("queuethread/submit/IDLE_SPIN_THEN_PARK", NUM_LATENCY,
+                   [](BenchmarkState &state){submitRoundTrip(state, QueueThread::IDLE_SPIN_THEN_PARK);});
+
+        for(size_t t = 0; t < NUM_ARRAY(types); t++){
+            ContainerType type = types[t];
+            runner.add(std::string("container/") + CONTAINER_NAMES[type], NUM_CONTAINER_OP,
+                       [type](BenchmarkState &state){containerOperation(state, type);});
+        }
+    }
+
+}; //namespace SThreadBenchmark
@@ -0,0 +1,231 @@
+#include "Benchmark.h"
+
+using namespace SThread;
+
+namespace SThreadBenchmark{
+
+    static const unsigned long long NUM_TICK = 1 << 10;
+    static const int GRAPH_WIDTH = 20;
+    static const int GRAPH_DEPTH = 10;
+    static const unsigned long long NUM_CALL = 1 << 6;
+    static const size_t NUM_ELEMENT = 1 << 20;
+
+    //! Work of one node, a few hundred nanoseconds
+    static void spinWork(std::atomic<unsigned long long> *numDone)
+    {
+        unsigned int seed = 1;
+        for(int i = 0; i < 64; i++){
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+        }
+        numDone->fetch_add(seed != 0, std::memory_order_relaxed);
+    }
+
+    /****************************************/
+    /*!
+        @brief	Layered DAG of GRAPH_WIDTH x GRAPH_DEPTH nodes
+        @note	Each node depends on two nodes of the previous
+                layer. One operation is one run of the graph.
+    */
+    /****************************************/
+    static void buildGraph(TaskGraph &graph, std::atomic<unsigned long long> *numDone)
+    {
+        std::vector<TaskNode*> previous;
+        for(int d = 0; d < GRAPH_DEPTH; d++){
+            std::vector<TaskNode*> layer;
+            for(int w = 0; w < GRAPH_WIDTH; w++){
+                TaskNode *node = graph.add([numDone](){spinWork(numDone);});
+                if(!previous.empty()){
+                    node->succeed(previous[w]);
+                    node->succeed(previous[(w + 1) % GRAPH_WIDTH]);
+                }
+                layer.push_back(node);
+            }
+            previous = layer;
+        }
+    }
+
+    template <class Pool>
+    static void taskGraphTick(BenchmarkState &state)
+    {
+        int numThread = BenchmarkRunner::getNumCore();
+        std::atomic<unsigned long long> numDone(0);
+
+        Pool pool(numThread);
+        pool.init();
+        pool.start();
+
+        TaskGraph graph;
+        buildGraph(graph, &numDone);
+
+        state.begin();
+        for(unsigned long long n = 0; n < state.getNumOp(); n++){
+            unsigned long long begin = Timer::now();
+            graph.run(pool);
+            graph.wait();
+            state.addSample(Timer::now() - begin);
+        }
+        state.end();
+
+        if(numDone.load() != state.getNumOp() * GRAPH_WIDTH * GRAPH_DEPTH) state.skip("lost nodes");
+
+        pool.shutdown();
+        pool.cleanup();
+    }
+
+    //! The same layers separated by waiting for every Future of a layer
+    template <class Pool>
+    static void layerBarrierTick(BenchmarkState &state)
+    {
+        int numThread = BenchmarkRunner::getNumCore();
+        std::atomic<unsigned long long> numDone(0);
+
+        Pool pool(numThread);
+        pool.init();
+        pool.start();
+
+        std::vector<Future<void>> futures(GRAPH_WIDTH);
+
+        state.begin();
+        for(unsigned long long n = 0; n < state.getNumOp(); n++){
+            unsigned long long begin = Timer::now();
+            for(int d = 0; d < GRAPH_DEPTH; d++){
+                for(int w = 0; w < GRAPH_WIDTH; w++) futures[w] = pool.submit([&numDone](){spinWork(&numDone);});
+                for(int w = 0; w < GRAPH_WIDTH; w++) futures[w].get();
+            }
+            state.addSample(Timer::now() - begin);
+        }
+        state.end();
+
+        if(numDone.load() != state.getNumOp() * GRAPH_WIDTH * GRAPH_DEPTH) state.skip("lost nodes");
+
+        pool.shutdown();
+        pool.cleanup();
+    }
+
+    //! parallelReduce of NUM_ELEMENT doubles, Pool is void for the serial loop
+    template <class Pool>
+    static void parallelReduceCall(BenchmarkState &state)
+    {
+        std::vector<double> values(NUM_ELEMENT);
+        for(size_t i = 0; i < values.size(); i++) values[i] = (double)(i % 1000) * 0.5;
+
+        auto sum = [&values](size_t first, size_t last){
+            double ret = 0.0;
+            for(size_t i = first; i < last; i++) ret += values[i] * values[i];
+            return ret;
+        };
+
+        double expect = sum(0, values.size());
+        double result = 0.0;
+        if constexpr (std::is_void<Pool>::value){
+            state.begin();
+            for(unsigned long long n = 0; n < state.getNumOp(); n++) result = sum(0, values.size());
+            state.end();
+        }
+        else{
+            Pool pool(BenchmarkRunner::getNumCore());
+            pool.init();
+            pool.start();
+
+            state.begin();
+            for(unsigned long long n = 0; n < state.getNumOp(); n++){
+                result = parallelReduce(pool, (size_t)0, values.size(), (size_t)0, 0.0, sum, [](double a, double b){return a + b;});
+            }
+            state.end();
+
+            pool.shutdown();
+            pool.cleanup();
+        }
+
+        if(fabs(result - expect) > expect * 1e-9) state.skip("wrong sum");
+    }
+
+    //! parallelSort of NUM_ELEMENT shuffled ints, Pool is void for std::stable_sort
+    template <class Pool>
+    static void parallelSortCall(BenchmarkState &state)
+    {
+        std::vector<int> source(NUM_ELEMENT);
+        unsigned int seed = 1;
+        for(size_t i = 0; i < source.size(); i++){
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            source[i] = (int)(seed >> 1);
+        }
+        std::vector<int> values(source.size());
+        bool isSorted = TRUE;
+
+        if constexpr (std::is_void<Pool>::value){
+            state.begin();
+            for(unsigned long long n = 0; n < state.getNumOp(); n++){
+                values = source;
+                std::stable_sort(values.begin(), values.end());
+            }
+            state.end();
+            isSorted = std::is_sorted(values.begin(), values.end());
+        }
+        else{
+            Pool pool(BenchmarkRunner::getNumCore());
+            pool.init();
+            pool.start();
+
+            state.begin();
+            for(unsigned long long n = 0; n < state.getNumOp(); n++){
+                values = source;
+                parallelSort(pool, values.begin(), values.end());
+            }
+            state.end();
+            isSorted = std::is_sorted(values.begin(), values.end());
+
+            pool.shutdown();
+            pool.cleanup();
+        }
+
+        if(!isSorted) state.skip("not sorted");
+    }
+
+    template <class Pool>
+    static Task<void> hopTask(Pool &pool, BenchmarkState &state)
+    {
+        for(unsigned long long n = 0; n < state.getNumOp(); n++){
+            unsigned long long begin = Timer::now();
+            co_await scheduleOn(pool);
+            state.addSample(Timer::now() - begin);
+        }
+    }
+
+    //! One operation is one co_await scheduleOn(pool), i.e. one posted resumption
+    template <class Pool>
+    static void coroutineHop(BenchmarkState &state)
+    {
+        Pool pool(BenchmarkRunner::getNumCore());
+        pool.init();
+        pool.start();
+
+        state.begin();
+        startTask(hopTask(pool, state)).get();
+        state.end();
+
+        pool.shutdown();
+        pool.cleanup();
+    }
+
+    void registerTaskBenchmarks(BenchmarkRunner &runner)
+    {
+        runner.add("taskgraph/tick/WorkerThreadPool", NUM_TICK, taskGraphTick<WorkerThreadPool>);
+        runner.add("taskgraph/tick/WorkStealingPool", NUM_TICK, taskGraphTick<WorkStealingPool>);
+        runner.add("taskgraph/layer-barrier/WorkerThreadPool", NUM_TICK, layerBarrierTick<WorkerThreadPool>);
+        runner.add("taskgraph/layer-barrier/WorkStealingPool", NUM_TICK, layerBarrierTick<WorkStealingPool>);
+        runner.add("parallel/reduce/serial", NUM_CALL, parallelReduceCall<void>);
+        runner.add("parallel/reduce/WorkerThreadPool", NUM_CALL, parallelReduceCall<WorkerThreadPool>);
+        runner.add("parallel/reduce/WorkStealingPool", NUM_CALL, parallelReduceCall<WorkStealingPool>);
+        runner.add("parallel/sort/serial", NUM_CALL, parallelSortCall<void>);
+        runner.add("parallel/sort/WorkerThreadPool", NUM_CALL, parallelSortCall<WorkerThreadPool>);
+        runner.add("parallel/sort/WorkStealingPool", NUM_CALL, parallelSortCall<WorkStealingPool>);
+        runner.add("coroutine/hop/WorkerThreadPool", NUM_TICK * 64, coroutineHop<WorkerThreadPool>);
+        runner.add("coroutine/hop/WorkStealingPool", NUM_TICK * 64, coroutineHop<WorkStealingPool>);
+    }
+
+}; //namespace SThreadBenchmark
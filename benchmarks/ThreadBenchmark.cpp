@@ -0,0 +1,59 @@
+#include "Benchmark.h"
+
+using namespace SThread;
+
+namespace SThreadBenchmark{
+
+    static const unsigned long long NUM_ROUND_TRIP = 256;
+    static const unsigned long long NUM_QUEUETHREAD = 64;
+
+    /****************************************/
+    /*!
+        @brief	init -> start -> join -> cleanup of an empty thread
+        @note	Samples are start -> join only
+    */
+    /****************************************/
+    static void threadStartJoin(BenchmarkState &state)
+    {
+        state.begin();
+        for(unsigned long long n = 0; n < state.getNumOp(); n++){
+            FunctionThread thread([](){});
+            thread.init();
+
+            unsigned long long begin = Timer::now();
+            thread.start();
+            thread.join();
+            state.addSample(Timer::now() - begin);
+
+            thread.cleanup();
+        }
+        state.end();
+    }
+
+    //! Start and shut down parked QueueThreads
+    static void queueThreadStartShutdown(BenchmarkState &state)
+    {
+        std::vector<QueueThread*> threads;
+
+        state.begin();
+        for(unsigned long long n = 0; n < state.getNumOp(); n++){
+            QueueThread *thread = new QueueThread();
+            thread->init();
+            thread->start();
+            threads.push_back(thread);
+        }
+        for(size_t i = 0; i < threads.size(); i++){
+            threads[i]->shutdown();
+            threads[i]->cleanup();
+            delete threads[i];
+        }
+        state.end();
+    }
+
+    void registerThreadBenchmarks(BenchmarkRunner &runner)
+    {
+        runner.add("thread/start-join", NUM_ROUND_TRIP, threadStartJoin);
+        runner.add("thread/queuethread-start-shutdown", NUM_QUEUETHREAD, queueThreadStartShutdown);
+    }
+
+}; //namespace SThreadBenchmark
@@ -0,0 +1,20 @@
+#include "Benchmark.h"
+
+namespace SThreadBenchmark{
+    void registerLockBenchmarks(BenchmarkRunner &runner);
+    void registerQueueBenchmarks(BenchmarkRunner &runner);
+    void registerThreadBenchmarks(BenchmarkRunner &runner);
+    void registerTaskBenchmarks(BenchmarkRunner &runner);
+};
+
+int main(int argc, char **argv)
+{
+    SThreadBenchmark::BenchmarkRunner runner;
+
+    SThreadBenchmark::registerLockBenchmarks(runner);
+    SThreadBenchmark::registerQueueBenchmarks(runner);
+    SThreadBenchmark::registerThreadBenchmarks(runner);
+    SThreadBenchmark::registerTaskBenchmarks(runner);
+
+    return runner.run(argc, argv);
+}
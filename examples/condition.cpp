@@ -0,0 +1,176 @@
+#include "SThread/SThread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+using namespace SThread;
+
+//Condition stress: every wakeup must reach its waiter. Lost wakeups show as a
+//stall, the waits are effectively unbounded, so a watchdog reports them.
+//Build with -Dfutex=true to check the futex Condition.
+
+static const int NUM_ROUND = 200000;
+static const int NUM_RING_THREAD = 4;		//!< signalAll rings, signal() rings have two
+static const int NUM_QUEUE_REQUEST = 200000;
+static const unsigned int STALL_MILLI_SEC = 3000;
+
+/****************************************/
+/*!
+    @class	RingThread
+    @brief	Takes its turn in a ring sharing one Condition
+    @note	Signals after unlocking, like QueueThread::addRequest,
+            which is the window a waiter registering late hits.
+*/
+/****************************************/
+class RingThread : public Thread
+{
+public:
+    RingThread(Condition *condition, volatile int *turn, int index, int numThread, bool isAll, std::atomic<int> *progress)
+    :Thread(), mCondition(condition), mTurn(turn), mIndex(index), mNumThread(numThread), mIsAll(isAll), mProgress(progress){}
+
+protected:
+    virtual void run(){
+        for(int i = 0; i < NUM_ROUND; i++){
+            mCondition->lock();
+            while(*mTurn != mIndex) mCondition->wait();
+            *mTurn = (mIndex + 1) % mNumThread;
+            mCondition->unlock();
+
+            if(mIsAll) mCondition->signalAll();
+            else mCondition->signal();
+            mProgress->fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    Condition *mCondition;
+    volatile int *mTurn;
+    int mIndex;
+    int mNumThread;
+    bool mIsAll;
+    std::atomic<int> *mProgress;
+};
+
+class CountRequest : public WorkRequest
+{
+public:
+    explicit CountRequest(std::atomic<int> *progress)
+    :WorkRequest(), mProgress(progress){}
+
+protected:
+    virtual bool work(){
+        mProgress->fetch_add(1, std::memory_order_relaxed);
+        return TRUE;
+    }
+
+private:
+    std::atomic<int> *mProgress;
+};
+
+//! Wait until progress reaches total, FALSE if it stops moving for STALL_MILLI_SEC
+static bool watch(std::atomic<int> *progress, int total)
+{
+    int last = -1;
+    Timer stall;
+    while(progress->load() < total){
+        Timer::sleep(10);
+        int current = progress->load();
+        if(current != last){
+            last = current;
+            stall.reset();
+        }
+        else if(stall.getElapsedTime() > STALL_MILLI_SEC){
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+//! One ring per core, at least two. signal() wakes any one waiter, so its rings
+//! have one waiter at a time.
+static bool stressRing(int numRing, bool isAll)
+{
+    Condition *conditions = new Condition[numRing];
+    volatile int *turns = new int[numRing];
+    std::atomic<int> progress(0);
+    RingThread *threads[256];
+
+    int numRingThread = isAll ? NUM_RING_THREAD : 2;
+    int numThread = numRing * numRingThread;
+    for(int r = 0; r < numRing; r++) turns[r] = 0;
+    for(int i = 0; i < numThread; i++){
+        int ring = i / numRingThread;
+        threads[i] = new RingThread(&conditions[ring], &turns[ring], i % numRingThread, numRingThread, isAll, &progress);
+        threads[i]->init();
+        threads[i]->start();
+    }
+
+    Timer timer;
+    if(!watch(&progress, numThread * NUM_ROUND)) return FALSE;
+    printf("%-28s%8u ms\n", isAll ? "ring, signalAll" : "ring, signal", timer.getElapsedTime());
+
+    for(int i = 0; i < numThread; i++){
+        threads[i]->cleanup();
+        delete threads[i];
+    }
+    delete[] turns;
+    delete[] conditions;
+    return TRUE;
+}
+
+//! Bursty producers, so the consumer parks between bursts
+static bool stressQueue(int numProducer)
+{
+    std::atomic<int> progress(0);
+    QueueThread consumer;
+    consumer.init();
+    consumer.start();
+
+    std::thread *producers[64];
+    int perProducer = NUM_QUEUE_REQUEST / numProducer;
+    for(int p = 0; p < numProducer; p++){
+        producers[p] = new std::thread([&consumer, &progress, perProducer, p](){
+            for(int i = 0; i < perProducer; i++){
+                consumer.addRequest(new CountRequest(&progress));
+                if((i + p) % 64 == 0) std::this_thread::yield();
+            }
+        });
+    }
+
+    Timer timer;
+    bool ret = watch(&progress, perProducer * numProducer);
+    if(!ret) return FALSE;
+    printf("%-28s%8u ms\n", "QueueThread, bursts", timer.getElapsedTime());
+
+    for(int p = 0; p < numProducer; p++){
+        producers[p]->join();
+        delete producers[p];
+    }
+    consumer.cleanup();
+    return ret;
+}
+
+int main()
+{
+    int numCore = (int)std::thread::hardware_concurrency();
+    if(numCore <= 0) numCore = 1;
+    int numRing = numCore < 2 ? 2 : (numCore > 64 ? 64 : numCore);
+    int numProducer = numCore < 2 ? 2 : (numCore > 64 ? 64 : numCore);
+
+#if defined USE_FUTEX_INTERFACE
+    printf("futex Condition, %d cores\n", numCore);
+#else
+    printf("native Condition, %d cores\n", numCore);
+#endif
+
+    if(!stressRing(numRing, FALSE) || !stressRing(numRing, TRUE) || !stressQueue(numProducer)){
+        //the stalled threads cannot be joined
+        printf("stalled for %u ms: lost wakeup\n", STALL_MILLI_SEC);
+        fflush(stdout);
+        exit(1);
+    }
+
+    printf("no lost wakeup\n");
+    return 0;
+}
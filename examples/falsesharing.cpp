@@ -0,0 +1,108 @@
+#include "SThread/SThread.h"
+
+#include <stdio.h>
+#include <thread>
+
+using namespace SThread;
+
+static const int NUM_INCREMENT = 2000000;
+static const int MAX_THREAD = 16;
+
+//every thread writes only its own counter; the packed layout puts
+//them on one line, so each write invalidates the other cores' copy
+struct PackedCounters
+{
+    std::atomic<long> count[MAX_THREAD];
+};
+
+struct PaddedCounters
+{
+    CachePadded<std::atomic<long> > count[MAX_THREAD];
+};
+
+class IncrementThread : public Thread
+{
+public:
+    IncrementThread(std::atomic<long> *counter, std::atomic<bool> *isGo)
+    :Thread(), mCounter(counter), mIsGo(isGo){}
+
+protected:
+    virtual void run(){
+        while(!mIsGo->load()) CPU_PAUSE();
+
+        for(int i = 0; i < NUM_INCREMENT; i++){
+            mCounter->fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::atomic<long> *mCounter;
+    std::atomic<bool> *mIsGo;
+};
+
+static unsigned int measure(std::atomic<long> **counters, int numThread)
+{
+    std::atomic<bool> isGo(FALSE);
+    IncrementThread *threads[MAX_THREAD];
+
+    for(int i = 0; i < numThread; i++){
+        counters[i]->store(0);
+        threads[i] = new IncrementThread(counters[i], &isGo);
+        threads[i]->init();
+        threads[i]->start();
+    }
+
+    Timer timer;
+    isGo.store(TRUE);
+    for(int i = 0; i < numThread; i++) threads[i]->join();
+    unsigned int elapsed = timer.getElapsedTime();
+
+    for(int i = 0; i < numThread; i++){
+        threads[i]->cleanup();
+        delete threads[i];
+    }
+    return elapsed;
+}
+
+int main()
+{
+    const int numThreads[] = {1, 2, 4, 8, 16};
+
+    int numCore = (int)std::thread::hardware_concurrency();
+    if(numCore <= 0) numCore = 1;
+
+    static PackedCounters packed;
+    static PaddedCounters padded;
+
+    std::atomic<long> *packedPtr[MAX_THREAD];
+    std::atomic<long> *paddedPtr[MAX_THREAD];
+    for(int i = 0; i < MAX_THREAD; i++){
+        packedPtr[i] = &packed.count[i];
+        paddedPtr[i] = padded.count[i].get();
+    }
+
+    printf("%d private increments per thread, time in ms, %d cores\n", NUM_INCREMENT, numCore);
+    printf("sizeof(SpinLock) %u, sizeof(Thread) %u, sizeof(QueueThread) %u\n",
+           (unsigned int)sizeof(SpinLock), (unsigned int)sizeof(Thread), (unsigned int)sizeof(QueueThread));
+    printf("%-16s", "threads");
+    for(size_t t = 0; t < NUM_ARRAY(numThreads); t++) printf("%8d", numThreads[t]);
+    printf("\n");
+
+    std::atomic<long> **layouts[] = {packedPtr, paddedPtr};
+    const char *names[] = {"packed", "CachePadded"};
+
+    for(size_t l = 0; l < NUM_ARRAY(layouts); l++){
+        printf("%-16s", names[l]);
+        for(size_t t = 0; t < NUM_ARRAY(numThreads); t++){
+            if(numThreads[t] > numCore && numThreads[t] > 1){
+                printf("%8s", "-");
+                continue;
+            }
+            printf("%8u", measure(layouts[l], numThreads[t]));
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
@@ -1,11 +1,210 @@
 
-
 #include "SThread/SThread.h"
 
+#include <stdio.h>
+#include <thread>
+
 using namespace SThread;
 
+static const int NUM_TOTAL_LOCK = 400000;
+
+static volatile long gCounter = 0;
+
+class ContentionThread : public Thread
+{
+public:
+    ContentionThread(ResourceLock *locker, int numLock, std::atomic<bool> *isGo)
+    :Thread(), mLocker(locker), mNumLock(numLock), mIsGo(isGo){}
+
+protected:
+    virtual void run(){
+        while(!mIsGo->load()) CPU_PAUSE();
+
+        for(int i = 0; i < mNumLock; i++){
+            mLocker->lock();
+            gCounter = gCounter + 1;
+            mLocker->unlock();
+        }
+    }
+
+private:
+    ResourceLock *mLocker;
+    int mNumLock;
+    std::atomic<bool> *mIsGo;
+};
+
+static unsigned int measure(ResourceLock *locker, int numThread)
+{
+    std::atomic<bool> isGo(FALSE);
+    ContentionThread *threads[64];
+
+    gCounter = 0;
+    for(int i = 0; i < numThread; i++){
+        threads[i] = new ContentionThread(locker, NUM_TOTAL_LOCK / numThread, &isGo);
+        threads[i]->init();
+        threads[i]->start();
+    }
+
+    Timer timer;
+    isGo.store(TRUE);
+    for(int i = 0; i < numThread; i++) threads[i]->join();
+    unsigned int elapsed = timer.getElapsedTime();
+
+    for(int i = 0; i < numThread; i++){
+        threads[i]->cleanup();
+        delete threads[i];
+    }
+    return elapsed;
+}
+
+//read-mostly: one write per WRITE_INTERVAL reads
+static const int WRITE_INTERVAL = 64;
+
+struct Snapshot
+{
+    long value[4];
+};
+
+class ReaderThread : public Thread
+{
+public:
+    enum ReadMode
+    {
+        READ_MUTEX,
+        READ_RWLOCK,
+        READ_SEQLOCK,
+    };
+
+public:
+    ReaderThread(ReadMode mode, Mutex *mutex, RWLock *rwlock, SeqLock<Snapshot> *seqlock, Snapshot *shared, int numRead, std::atomic<bool> *isGo)
+    :Thread(), mMode(mode), mMutex(mutex), mRWLock(rwlock), mSeqLock(seqlock), mShared(shared), mNumRead(numRead), mIsGo(isGo){}
+
+protected:
+    virtual void run(){
+        while(!mIsGo->load()) CPU_PAUSE();
+
+        long sum = 0;
+        for(int i = 0; i < mNumRead; i++){
+            bool isWrite = (i % WRITE_INTERVAL) == 0;
+            switch(mMode){
+            case READ_MUTEX:{
+                LockHolder holder(mMutex);
+                if(isWrite) mShared->value[0]++;
+                else sum += mShared->value[0];
+                break;
+            }
+            case READ_RWLOCK:
+                if(isWrite){
+                    WriteLockHolder holder(mRWLock);
+                    mShared->value[0]++;
+                }else{
+                    ReadLockHolder holder(mRWLock);
+                    sum += mShared->value[0];
+                }
+                break;
+            case READ_SEQLOCK:
+                if(isWrite){
+                    SeqLockWriteHolder<Snapshot> holder(mSeqLock);
+                    holder->value[0]++;
+                }else{
+                    sum += mSeqLock->read().value[0];
+                }
+                break;
+            }
+        }
+        mSum = sum;
+    }
+
+private:
+    ReadMode mMode;
+    Mutex *mMutex;
+    RWLock *mRWLock;
+    SeqLock<Snapshot> *mSeqLock;
+    Snapshot *mShared;
+    int mNumRead;
+    std::atomic<bool> *mIsGo;
+    volatile long mSum;
+};
+
+static unsigned int measureRead(ReaderThread::ReadMode mode, int numThread)
+{
+    Mutex mutex;
+    RWLock rwlock;
+    SeqLock<Snapshot> seqlock;
+    Snapshot shared = {{0, 0, 0, 0}};
+
+    std::atomic<bool> isGo(FALSE);
+    ReaderThread *threads[64];
+
+    for(int i = 0; i < numThread; i++){
+        threads[i] = new ReaderThread(mode, &mutex, &rwlock, &seqlock, &shared, NUM_TOTAL_LOCK * 4 / numThread, &isGo);
+        threads[i]->init();
+        threads[i]->start();
+    }
+
+    Timer timer;
+    isGo.store(TRUE);
+    for(int i = 0; i < numThread; i++) threads[i]->join();
+    unsigned int elapsed = timer.getElapsedTime();
+
+    for(int i = 0; i < numThread; i++){
+        threads[i]->cleanup();
+        delete threads[i];
+    }
+    return elapsed;
+}
+
 int main()
 {
+    const int numThreads[] = {1, 2, 4, 8, 16, 32, 64};
+
+    //more threads than cores measures the scheduler rather than the lock
+    int numCore = (int)std::thread::hardware_concurrency();
+    if(numCore <= 0) numCore = 1;
+
+    Mutex mutex;
+    SpinLock spin;
+    BackoffSpinLock backoff;
+    TicketSpinLock ticket;
+    MCSLock mcs;
+
+    ResourceLock *lockers[] = {&mutex, &spin, &backoff, &ticket, &mcs};
+    const char *names[] = {"Mutex", "SpinLock", "BackoffSpinLock", "TicketSpinLock", "MCSLock"};
+
+    printf("%d lock/unlock pairs in total, time in ms, %d cores\n", NUM_TOTAL_LOCK, numCore);
+    printf("%-16s", "threads");
+    for(size_t t = 0; t < NUM_ARRAY(numThreads); t++) printf("%8d", numThreads[t]);
+    printf("\n");
+
+    for(size_t l = 0; l < NUM_ARRAY(lockers); l++){
+        printf("%-16s", names[l]);
+        for(size_t t = 0; t < NUM_ARRAY(numThreads); t++){
+            if(numThreads[t] > numCore && numThreads[t] > 1){
+                printf("%8s", "-");
+                continue;
+            }
+            printf("%8u", measure(lockers[l], numThreads[t]));
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+
+    const ReaderThread::ReadMode modes[] = {ReaderThread::READ_MUTEX, ReaderThread::READ_RWLOCK, ReaderThread::READ_SEQLOCK};
+    const char *modeNames[] = {"Mutex", "RWLock", "SeqLock"};
+
+    printf("\n%d reads (1/%d writes) in total, time in ms\n", NUM_TOTAL_LOCK * 4, WRITE_INTERVAL);
+    for(size_t m = 0; m < NUM_ARRAY(modes); m++){
+        printf("%-16s", modeNames[m]);
+        for(size_t t = 0; t < NUM_ARRAY(numThreads); t++){
+            if(numThreads[t] > numCore && numThreads[t] > 1){
+                printf("%8s", "-");
+                continue;
+            }
+            printf("%8u", measureRead(modes[m], numThreads[t]));
+            fflush(stdout);
+        }
+        printf("\n");
+    }
 
     return 0;
-}
\ No newline at end of file
+}
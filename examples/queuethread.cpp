@@ -1,11 +1,238 @@
 
-
 #include "SThread/SThread.h"
 
+#include <stdio.h>
+#include <sched.h>
+
 using namespace SThread;
 
+static const int NUM_PRODUCER = 4;
+static const int NUM_REQUEST_PER_PRODUCER = 200000;
+
+static std::atomic<int> gNumDone(0);
+
+class CountRequest : public WorkRequest
+{
+public:
+    explicit CountRequest(int priority = PRIORITY_NORMAL):WorkRequest(priority, TRUE){}
+
+private:
+    virtual bool work(){
+        gNumDone.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+class ProducerThread : public Thread
+{
+public:
+    explicit ProducerThread(QueueThread *target):Thread(), mTarget(target){}
+
+protected:
+    virtual void run(){
+        for(int i = 0; i < NUM_REQUEST_PER_PRODUCER; i++){
+            WorkRequest *req = new CountRequest();
+            while(!mTarget->addRequest(req)) sched_yield();
+        }
+    }
+
+private:
+    QueueThread *mTarget;
+};
+
+//! Splits itself into two sub-requests until depth reaches 0
+class FanOutRequest : public WorkRequest
+{
+public:
+    FanOutRequest(WorkStealingPool *pool, int depth)
+    :WorkRequest(PRIORITY_NORMAL, TRUE), mPool(pool), mDepth(depth){}
+
+private:
+    virtual bool work(){
+        gNumDone.fetch_add(1, std::memory_order_relaxed);
+        if(mDepth > 0){
+            mPool->addRequest(new FanOutRequest(mPool, mDepth - 1));
+            mPool->addRequest(new FanOutRequest(mPool, mDepth - 1));
+        }
+        return true;
+    }
+
+    WorkStealingPool *mPool;
+    int mDepth;
+};
+
+static unsigned int measure(RequestContainer *container, int drainBatchSize = 1)
+{
+    gNumDone.store(0);
+
+    QueueThread consumer(container);
+    consumer.init();
+    consumer.setDrainBatchSize(drainBatchSize);
+    consumer.start();
+
+    ProducerThread *producers[NUM_PRODUCER];
+    for(int i = 0; i < NUM_PRODUCER; i++){
+        producers[i] = new ProducerThread(&consumer);
+        producers[i]->init();
+    }
+
+    Timer timer;
+    for(int i = 0; i < NUM_PRODUCER; i++) producers[i]->start();
+
+    const int total = NUM_PRODUCER * NUM_REQUEST_PER_PRODUCER;
+    while(gNumDone.load() < total) sched_yield();
+    unsigned int elapsed = timer.getElapsedTime();
+
+    for(int i = 0; i < NUM_PRODUCER; i++){
+        producers[i]->cleanup();
+        delete producers[i];
+    }
+    consumer.cleanup();
+
+    return elapsed;
+}
+
+static unsigned int measureBurst(RequestContainer *container, int burst)
+{
+    gNumDone.store(0);
+
+    QueueThread consumer(container);
+    consumer.init();
+    consumer.start();
+
+    const int total = NUM_PRODUCER * NUM_REQUEST_PER_PRODUCER;
+    WorkRequest **reqs = new WorkRequest*[burst];
+
+    Timer timer;
+    for(int i = 0; i < total; i += burst){
+        for(int j = 0; j < burst; j++) reqs[j] = new CountRequest();
+        if(burst == 1){
+            while(!consumer.addRequest(reqs[0])) sched_yield();
+        }
+        else{
+            int added = 0;
+            while(added < burst){
+                added += consumer.addRequests(reqs + added, burst - added);
+                if(added < burst) sched_yield();
+            }
+        }
+    }
+    while(gNumDone.load() < total) sched_yield();
+    unsigned int elapsed = timer.getElapsedTime();
+
+    delete[] reqs;
+    consumer.cleanup();
+
+    return elapsed;
+}
+
+static void reportIdle(QueueThread::IdlePolicy policy, const char *name)
+{
+    gNumDone.store(0);
+
+    QueueThread consumer;
+    consumer.init();
+    consumer.setIdlePolicy(policy);
+    consumer.start();
+
+    //sparse arrivals so that the consumer goes idle between requests
+    const int num = 2000;
+    for(int i = 0; i < num; i++){
+        consumer.addRequest(new CountRequest());
+        for(int j = 0; j < 200; j++) CPU_PAUSE();
+        if(i % 100 == 0) Timer::sleep(1);
+    }
+    while(gNumDone.load() < num) sched_yield();
+
+    QueueThread::IdleStatistics stat = consumer.getIdleStatistics();
+    printf("%-21s : spin %lu, yield %lu, park %lu (spin budget %d)\n", name, stat.numSpin, stat.numYield, stat.numPark, stat.spinBudget);
+
+    consumer.cleanup();
+}
+
+static unsigned int measurePool(int numThread, RequestContainer *container)
+{
+    gNumDone.store(0);
+
+    WorkerThreadPool pool(numThread, container);
+    pool.init();
+    pool.start();
+
+    const int total = NUM_PRODUCER * NUM_REQUEST_PER_PRODUCER;
+    const int priorities[] = {
+        WorkRequest::PRIORITY_LOW,
+        WorkRequest::PRIORITY_NORMAL,
+        WorkRequest::PRIORITY_HIGH,
+        WorkRequest::PRIORITY_URGENT,
+    };
+
+    Timer timer;
+    for(int i = 0; i < total; i++){
+        pool.addRequest(new CountRequest(priorities[i % NUM_ARRAY(priorities)]));
+    }
+    while(gNumDone.load() < total) sched_yield();
+    unsigned int elapsed = timer.getElapsedTime();
+
+    pool.cleanup();
+
+    return elapsed;
+}
+
+static unsigned int measureFanOut(int numThread, int depth)
+{
+    gNumDone.store(0);
+
+    WorkStealingPool pool(numThread);
+    pool.init();
+    pool.start();
+
+    const int total = (1 << (depth + 1)) - 1;
+
+    Timer timer;
+    pool.addRequest(new FanOutRequest(&pool, depth));
+    while(gNumDone.load() < total) sched_yield();
+    unsigned int elapsed = timer.getElapsedTime();
+
+    pool.cleanup();
+
+    return elapsed;
+}
+
 int main()
 {
+    const int total = NUM_PRODUCER * NUM_REQUEST_PER_PRODUCER;
+
+    unsigned int queueTime = measure(new QueueRequestContainer());
+    unsigned int mpscTime = measure(new MPSCRequestContainer(8192));
+    unsigned int drainTime = measure(new QueueRequestContainer(), 64);
+
+    printf("%d producers, %d requests\n", NUM_PRODUCER, total);
+    printf("QueueRequestContainer : %6u ms (%.0f req/s)\n", queueTime, total * 1000.0 / (queueTime ? queueTime : 1));
+    printf("MPSCRequestContainer  : %6u ms (%.0f req/s)\n", mpscTime, total * 1000.0 / (mpscTime ? mpscTime : 1));
+    printf("Queue, drain x64      : %6u ms (%.0f req/s)\n", drainTime, total * 1000.0 / (drainTime ? drainTime : 1));
+
+    unsigned int singleTime = measureBurst(new QueueRequestContainer(), 1);
+    unsigned int burstTime = measureBurst(new QueueRequestContainer(), 256);
+    printf("addRequest  x1        : %6u ms (%.0f req/s)\n", singleTime, total * 1000.0 / (singleTime ? singleTime : 1));
+    printf("addRequests x256      : %6u ms (%.0f req/s)\n", burstTime, total * 1000.0 / (burstTime ? burstTime : 1));
+
+    reportIdle(QueueThread::IDLE_PARK, "IDLE_PARK");
+    reportIdle(QueueThread::IDLE_SPIN_THEN_PARK, "IDLE_SPIN_THEN_PARK");
+
+    unsigned int poolTime = measurePool(NUM_PRODUCER, new WorkerRequestContainer());
+    printf("WorkerThreadPool(%d)   : %6u ms (%.0f req/s) WorkerRequestContainer\n", NUM_PRODUCER, poolTime, total * 1000.0 / (poolTime ? poolTime : 1));
+    unsigned int bucketTime = measurePool(NUM_PRODUCER, new PriorityBucketRequestContainer());
+    printf("WorkerThreadPool(%d)   : %6u ms (%.0f req/s) PriorityBucketRequestContainer\n", NUM_PRODUCER, bucketTime, total * 1000.0 / (bucketTime ? bucketTime : 1));
+
+    const int depth = 19;
+    unsigned int fanOutTime = measureFanOut(NUM_PRODUCER, depth);
+    printf("WorkStealingPool(%d)   : %6u ms for a fan-out tree of %d requests\n", NUM_PRODUCER, fanOutTime, (1 << (depth + 1)) - 1);
+
+    //built with -Dlock_profile=true
+    if(LockProfiler::isEnabled()){
+        printf("\n");
+        LockProfiler::report();
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -1,11 +1,78 @@
-
-
 #include "SThread/SThread.h"
 
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+
 using namespace SThread;
 
+static const int NUM_ROUND_TRIP = 2000;
+static const int NUM_SERVICE_THREAD = 256;
+
+class EmptyThread : public Thread
+{
+protected:
+    virtual void run(){}
+};
+
+//create -> run -> join of a thread doing nothing
+static void measureRoundTrip()
+{
+    std::vector<unsigned long long> samples;
+    samples.reserve(NUM_ROUND_TRIP);
+
+    for(int i = 0; i < NUM_ROUND_TRIP; i++){
+        EmptyThread thread;
+        thread.init();
+
+        unsigned long long begin = Timer::now();
+        thread.start();
+        thread.join();
+        samples.push_back(Timer::now() - begin);
+
+        thread.cleanup();
+    }
+
+    std::stable_sort(samples.begin(), samples.end());
+    printf("start -> join        : p50 %8.1f us, p99 %8.1f us, max %8.1f us\n",
+           samples[samples.size() / 2] / 1000.0,
+           samples[samples.size() * 99 / 100] / 1000.0,
+           samples.back() / 1000.0);
+}
+
+//parked QueueThreads, the teardown of a service
+static void measureServiceShutdown()
+{
+    std::vector<QueueThread*> threads;
+
+    Timer timer;
+    for(int i = 0; i < NUM_SERVICE_THREAD; i++){
+        QueueThread *thread = new QueueThread();
+        thread->init();
+        thread->start();
+        threads.push_back(thread);
+    }
+    unsigned long long startTime = timer.getElapsedNanoTime();
+
+    timer.reset();
+    for(size_t i = 0; i < threads.size(); i++){
+        threads[i]->shutdown();
+    }
+    unsigned long long shutdownTime = timer.getElapsedNanoTime();
+
+    for(size_t i = 0; i < threads.size(); i++){
+        threads[i]->cleanup();
+        delete threads[i];
+    }
+
+    printf("%d QueueThreads    : start %8.2f ms, shutdown %8.2f ms\n",
+           NUM_SERVICE_THREAD, startTime / 1000000.0, shutdownTime / 1000000.0);
+}
+
 int main()
 {
+    measureRoundTrip();
+    measureServiceShutdown();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,97 @@
+
+#include "SThread/SThread.h"
+
+#include <stdio.h>
+#include <sched.h>
+
+using namespace SThread;
+
+static std::atomic<int> gNumDone(0);
+
+//! Busy work of a given length, with an occasional long one
+class SpinRequest : public WorkRequest
+{
+public:
+    explicit SpinRequest(unsigned long long nanoSec):WorkRequest(PRIORITY_NORMAL, TRUE), mNanoSec(nanoSec){}
+
+private:
+    virtual bool work(){
+        unsigned long long end = Timer::now() + mNanoSec;
+        while(Timer::now() < end) CPU_PAUSE();
+        gNumDone.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    unsigned long long mNanoSec;
+};
+
+class ProducerThread : public Thread
+{
+public:
+    ProducerThread(WorkerThreadPool *pool, int num):Thread(), mPool(pool), mNum(num){}
+
+protected:
+    virtual void run(){
+        for(int i = 0; i < mNum; i++){
+            mPool->addRequest(new SpinRequest(i % 50 == 0 ? 200000 : 5000));
+            if(i % 10 == 0) Timer::sleep(1);
+        }
+    }
+
+private:
+    WorkerThreadPool *mPool;
+    int mNum;
+};
+
+int main(int argc, char **argv)
+{
+    const char *jsonPath = argc > 1 ? argv[1] : "sthread_trace.json";
+    const char *perfettoPath = argc > 2 ? argv[2] : "sthread_trace.perfetto-trace";
+
+    Tracer::enable();
+    Tracer::setCurrentThreadName("main");
+
+    //pool workers are named "worker <n>"
+    WorkerThreadPool pool(2);
+    pool.init();
+    pool.start();
+
+    QueueThread queue;
+    queue.setName("queue");
+    queue.init();
+    queue.start();
+
+    const int NUM_PRODUCER = 2;
+    const int NUM_REQUEST = 200;
+    ProducerThread *producers[NUM_PRODUCER];
+    for(int i = 0; i < NUM_PRODUCER; i++){
+        producers[i] = new ProducerThread(&pool, NUM_REQUEST);
+        producers[i]->setName("producer " + std::to_string(i));
+        producers[i]->init();
+        producers[i]->start();
+    }
+
+    //suspended queue: requests wait until resume
+    queue.suspend();
+    for(int i = 0; i < 20; i++) queue.addRequest(new SpinRequest(10000));
+    Timer::sleep(5);
+    queue.resume();
+
+    const int total = NUM_PRODUCER * NUM_REQUEST + 20;
+    while(gNumDone.load() < total) sched_yield();
+
+    for(int i = 0; i < NUM_PRODUCER; i++){
+        producers[i]->cleanup();
+        delete producers[i];
+    }
+    queue.cleanup();
+    pool.cleanup();
+
+    Tracer::disable();
+    bool isJson = Tracer::write(jsonPath, TRACE_FORMAT_CHROME_JSON);
+    bool isPerfetto = Tracer::write(perfettoPath, TRACE_FORMAT_PERFETTO);
+
+    printf("%s : %s (chrome://tracing or ui.perfetto.dev)\n", jsonPath, isJson ? "written" : "failed");
+    printf("%s : %s (ui.perfetto.dev)\n", perfettoPath, isPerfetto ? "written" : "failed");
+    return isJson && isPerfetto ? 0 : 1;
+}
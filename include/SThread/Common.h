@@ -156,6 +156,10 @@
 #define USE_PTHREAD_INTERFACE
 #define USE_BSDSOCKET_INTERFACE
 
+#if defined OS_LINUX && defined STHREAD_USE_FUTEX
+#define USE_FUTEX_INTERFACE
+#endif
+
 //Strings
 //#define BASICSTRING_16BIT
 #define BASICSTRING_8BIT
@@ -286,6 +290,11 @@
 
 #endif
 
+//Cache line size//////////////////////////
+#ifndef CACHE_LINE_BYTE_SIZE
+#define CACHE_LINE_BYTE_SIZE 64
+#endif
+
 #if defined BASICSTRING_16BIT
 
     #ifndef BASE_TEXT
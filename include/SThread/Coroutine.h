@@ -0,0 +1,503 @@
+/******************************************************************/
+/*!
+	@file	Coroutine.h
+	@brief	C++20 coroutines on QueueThread and the pools
+	@note	Task<T> is a lazy coroutine, awaiting it starts it and
+			resumes the awaiter when it finishes. scheduleOn() moves
+			a coroutine to an executor as a posted request, the
+			Condition, timer and join awaitables park it as a
+			WaitNode and post it back to an executor when woken, so
+			a suspended flow holds no thread.
+	@todo
+	@bug
+
+	@author	Naoto Nakamura
+	@date	Oct. 18, 2026
+*/
+/******************************************************************/
+
+#ifndef STHREAD_COROUTINE_H
+#define STHREAD_COROUTINE_H
+
+#include "SThread/Common.h"
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "SThread/Future.h"
+#include "SThread/QueueThread.h"
+#include "SThread/TimerThread.h"
+
+
+namespace SThread{
+    //////////////////////////////////////////////////
+    //				forward declarations			//
+    //////////////////////////////////////////////////
+    //implemented
+    class TaskPromiseBase;
+    template <class T> class TaskPromise;
+    template <class T> class Task;
+    class DetachedTask;
+    struct ResumeNode;
+    template <class Executor> class ScheduleAwaiter;
+    class ConditionAwaiter;
+    class SleepAwaiter;
+    class JoinAwaiter;
+
+    //////////////////////////////////////////////////
+    //				class declarations				//
+    //////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @class	TaskPromiseBase
+        @brief	Continuation and exception of a Task
+        @note	The final suspend transfers to the awaiting
+                coroutine, so a chain of tasks does not grow
+                the stack.
+    */
+    /****************************************/
+    class TaskPromiseBase
+    {
+    public:
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept {return FALSE;}
+
+            template <class Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+            {
+                TaskPromiseBase &promise = handle.promise();
+                if(promise.mContinuation) return promise.mContinuation;
+                return std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+        };
+
+    public:
+        std::suspend_always initial_suspend() noexcept {return std::suspend_always();}
+        FinalAwaiter final_suspend() noexcept {return FinalAwaiter();}
+
+        void unhandled_exception(){mException = std::current_exception();}
+
+        void setContinuation(std::coroutine_handle<> continuation){mContinuation = continuation;}
+
+    protected:
+        void rethrow()
+        {
+            if(mException) std::rethrow_exception(mException);
+        }
+
+    private:
+        std::coroutine_handle<> mContinuation;
+        std::exception_ptr mException;
+    };
+
+    template <class T>
+    class TaskPromise : public TaskPromiseBase
+    {
+    public:
+        Task<T> get_return_object();
+
+        template <class U>
+        void return_value(U &&value)
+        {
+            mValue.emplace(std::forward<U>(value));
+        }
+
+        T getResult()
+        {
+            rethrow();
+            return std::move(*mValue);
+        }
+
+    private:
+        std::optional<T> mValue;
+    };
+
+    template <>
+    class TaskPromise<void> : public TaskPromiseBase
+    {
+    public:
+        Task<void> get_return_object();
+
+        void return_void(){}
+
+        void getResult()
+        {
+            rethrow();
+        }
+    };
+
+    /****************************************/
+    /*!
+        @class	Task
+        @brief	Lazy coroutine returning T
+        @note	Move only, owns the frame. Starts when it is
+                co_awaited, or by startTask() from plain code.
+                An exception escapes to the awaiter.
+    */
+    /****************************************/
+    template <class T = void>
+    class Task
+    {
+    public:
+        typedef TaskPromise<T> promise_type;
+
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> handle;
+
+            //! An empty task has no result, as std::future without a state
+            bool await_ready()
+            {
+                if(!handle) throw std::future_error(std::future_errc::no_state);
+                return handle.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation)
+            {
+                handle.promise().setContinuation(continuation);
+                return handle;
+            }
+
+            T await_resume(){return handle.promise().getResult();}
+        };
+
+    public:
+        Task()
+        :mHandle(NULL)
+        {}
+
+        explicit Task(std::coroutine_handle<promise_type> handle)
+        :mHandle(handle)
+        {}
+
+        Task(Task &&task)
+        :mHandle(task.mHandle)
+        {
+            task.mHandle = NULL;
+        }
+
+        Task &operator=(Task &&task)
+        {
+            if(this != &task){
+                if(mHandle) mHandle.destroy();
+                mHandle = task.mHandle;
+                task.mHandle = NULL;
+            }
+            return *this;
+        }
+
+        ~Task()
+        {
+            if(mHandle) mHandle.destroy();
+        }
+
+    private:
+        Task(const Task&);
+        Task &operator=(const Task&);
+
+    public:
+        bool isValid()const{return (bool)mHandle;}
+        bool isDone()const{return mHandle && mHandle.done();}
+
+        Awaiter operator co_await(){return Awaiter{mHandle};}
+
+    private:
+        std::coroutine_handle<promise_type> mHandle;
+    };
+
+    template <class T>
+    Task<T> TaskPromise<T>::get_return_object()
+    {
+        return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+    }
+
+    inline Task<void> TaskPromise<void>::get_return_object()
+    {
+        return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+    }
+
+    /****************************************/
+    /*!
+        @class	DetachedTask
+        @brief	Eager coroutine which frees itself
+        @note	Bridge from plain code, see startTask().
+    */
+    /****************************************/
+    class DetachedTask
+    {
+    public:
+        struct promise_type
+        {
+            DetachedTask get_return_object(){return DetachedTask();}
+            std::suspend_never initial_suspend() noexcept {return std::suspend_never();}
+            std::suspend_never final_suspend() noexcept {return std::suspend_never();}
+            void return_void(){}
+            void unhandled_exception(){std::terminate();}
+        };
+    };
+
+    template <class T>
+    DetachedTask runDetached(Task<T> task, Promise<T> promise)
+    {
+        try{
+            if constexpr (std::is_void<T>::value){
+                co_await task;
+                promise.setValue();
+            }
+            else{
+                promise.setValue(co_await task);
+            }
+        }
+        catch(...){
+            promise.setException(std::current_exception());
+        }
+    }
+
+    //! Start task on the calling thread, the Future completes when it returns
+    template <class T>
+    Future<T> startTask(Task<T> &&task)
+    {
+        Promise<T> promise;
+        Future<T> ret = promise.getFuture();
+        runDetached(std::move(task), std::move(promise));
+        return ret;
+    }
+
+    /****************************************/
+    /*!
+        @struct	ResumeNode
+        @brief	WaitNode which resumes a coroutine on an executor
+        @note	The executor is anything with post(). When it
+                refuses the request (it is shutting down) the
+                coroutine resumes on the waking thread and
+                isPosted is FALSE.
+    */
+    /****************************************/
+    struct ResumeNode : public WaitNode
+    {
+        std::coroutine_handle<> handle;
+        void *executor;
+        bool (*post)(void *executor, std::coroutine_handle<> handle);
+        bool isPosted;
+
+        template <class Executor>
+        explicit ResumeNode(Executor &target)
+        :handle(NULL),
+        executor(&target),
+        post(&postResume<Executor>),
+        isPosted(FALSE)
+        {
+            next = NULL;
+            wake = &resume;
+        }
+
+        template <class Executor>
+        static bool postResume(void *executor, std::coroutine_handle<> handle)
+        {
+            return static_cast<Executor*>(executor)->post([handle](){handle.resume();});
+        }
+
+        //! The node is in the coroutine frame, it is not touched after post
+        static void resume(WaitNode *waitNode)
+        {
+            ResumeNode *node = static_cast<ResumeNode*>(waitNode);
+            std::coroutine_handle<> handle = node->handle;
+            node->isPosted = TRUE;
+            if(node->post(node->executor, handle)) return;
+            node->isPosted = FALSE;
+            handle.resume();
+        }
+    };
+
+    /****************************************/
+    /*!
+        @class	ScheduleAwaiter
+        @brief	co_await scheduleOn(executor)
+        @note	Resumes as a request of the given priority.
+                Returns FALSE if the executor refused it, the
+                coroutine then continues on the same thread.
+    */
+    /****************************************/
+    template <class Executor>
+    class ScheduleAwaiter
+    {
+    public:
+        ScheduleAwaiter(Executor &executor, const int priority)
+        :mExecutor(&executor),
+        mPriority(priority),
+        mIsScheduled(FALSE)
+        {}
+
+        bool await_ready(){return FALSE;}
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            mIsScheduled = TRUE;
+            if(mExecutor->post([handle](){handle.resume();}, mPriority)) return TRUE;
+            mIsScheduled = FALSE;
+            return FALSE;
+        }
+
+        bool await_resume(){return mIsScheduled;}
+
+    private:
+        Executor *mExecutor;
+        int mPriority;
+        bool mIsScheduled;
+    };
+
+    template <class Executor>
+    ScheduleAwaiter<Executor> scheduleOn(Executor &executor, const int priority = WorkRequest::PRIORITY_NORMAL)
+    {
+        return ScheduleAwaiter<Executor>(executor, priority);
+    }
+
+    /****************************************/
+    /*!
+        @class	ConditionAwaiter
+        @brief	co_await waitAsync(condition, executor)
+        @note	Await while holding the condition (or mutex),
+                like Condition::wait. It is released while
+                suspended. Returns TRUE on the executor with it
+                held again; spurious wakeups are possible, check
+                the predicate in a loop. Returns FALSE without
+                it if the executor refused the resumption: the
+                coroutine then runs inside signal() on the
+                signalling thread, which may hold the lock, so
+                it must not lock it there.
+    */
+    /****************************************/
+    class ConditionAwaiter
+    {
+    public:
+        template <class Executor>
+        ConditionAwaiter(Condition &condition, Executor &executor, Mutex *mutex)
+        :mCondition(&condition),
+        mMutex(mutex != NULL ? mutex : &condition),
+        mNode(executor)
+        {}
+
+        bool await_ready(){return FALSE;}
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            Mutex *mutex = mMutex;
+            mNode.handle = handle;
+            mCondition->addWaiter(&mNode);
+            mutex->unlock();
+        }
+
+        bool await_resume()
+        {
+            if(!mNode.isPosted) return FALSE;
+            mMutex->lock();
+            return TRUE;
+        }
+
+    private:
+        Condition *mCondition;
+        Mutex *mMutex;
+        ResumeNode mNode;
+    };
+
+    template <class Executor>
+    ConditionAwaiter waitAsync(Condition &condition, Executor &executor, Mutex *mutex = NULL)
+    {
+        return ConditionAwaiter(condition, executor, mutex);
+    }
+
+    /****************************************/
+    /*!
+        @class	SleepAwaiter
+        @brief	co_await sleepFor(timer, duration, executor)
+        @note	Returns TRUE once the deadline has passed,
+                FALSE if the timer woke it early at shutdown
+                or was not running.
+    */
+    /****************************************/
+    class SleepAwaiter
+    {
+    public:
+        template <class Executor>
+        SleepAwaiter(TimerThread &timer, const unsigned long long deadlineNanoSec, Executor &executor)
+        :mTimer(&timer),
+        mDeadline(deadlineNanoSec),
+        mNode(executor)
+        {}
+
+        bool await_ready(){return mDeadline <= Timer::getMonotonicNanoTime();}
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            mNode.handle = handle;
+            return mTimer->add(mDeadline, &mNode);
+        }
+
+        bool await_resume(){return mDeadline <= Timer::getMonotonicNanoTime();}
+
+    private:
+        TimerThread *mTimer;
+        unsigned long long mDeadline;
+        ResumeNode mNode;
+    };
+
+    template <class Rep, class Period, class Executor>
+    SleepAwaiter sleepFor(TimerThread &timer, const std::chrono::duration<Rep, Period> &duration, Executor &executor)
+    {
+        return SleepAwaiter(timer, Timer::getMonotonicNanoTime() + Timer::toNanoTime(duration), executor);
+    }
+
+    template <class Clock, class Duration, class Executor>
+    SleepAwaiter sleepUntil(TimerThread &timer, const std::chrono::time_point<Clock, Duration> &deadline, Executor &executor)
+    {
+        return SleepAwaiter(timer, Timer::toMonotonicNanoTime(deadline), executor);
+    }
+
+    /****************************************/
+    /*!
+        @class	JoinAwaiter
+        @brief	co_await joinAsync(thread, executor)
+        @note	Resumes after run() of thread has returned. The
+                OS thread may still be exiting, join() or
+                cleanup() then returns without a long wait.
+    */
+    /****************************************/
+    class JoinAwaiter
+    {
+    public:
+        template <class Executor>
+        JoinAwaiter(Thread &thread, Executor &executor)
+        :mThread(&thread),
+        mNode(executor)
+        {}
+
+        bool await_ready(){return mThread->getState() == Thread::THREAD_STOPED;}
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            mNode.handle = handle;
+            return mThread->addJoinWaiter(&mNode);
+        }
+
+        void await_resume(){}
+
+    private:
+        Thread *mThread;
+        ResumeNode mNode;
+    };
+
+    template <class Executor>
+    JoinAwaiter joinAsync(Thread &thread, Executor &executor)
+    {
+        return JoinAwaiter(thread, executor);
+    }
+
+}; //namespace SThread
+
+
+#endif //STHREAD_COROUTINE_H
@@ -0,0 +1,380 @@
+/******************************************************************/
+/*!
+	@file	Future.h
+	@brief	Result of a submitted request
+	@note	Promise and Future share a FutureState from an
+			ObjectPool. Completion is one atomic state word, waiters
+			block with std::atomic::wait (a futex on Linux) instead
+			of a Condition. A continuation added with then() runs on
+			the thread which completes the state, or on the caller
+			if it is already complete.
+	@todo
+	@bug
+
+	@author	Naoto Nakamura
+	@date	Oct. 18, 2026
+*/
+/******************************************************************/
+
+#ifndef STHREAD_FUTURE_H
+#define STHREAD_FUTURE_H
+
+#include "SThread/Common.h"
+
+#include <atomic>
+#include <exception>
+#include <future>
+#include <optional>
+#include <utility>
+#include <type_traits>
+
+#include "SThread/ObjectPool.h"
+#include "SThread/InlineFunction.h"
+
+
+namespace SThread{
+    //////////////////////////////////////////////////
+    //				forward declarations			//
+    //////////////////////////////////////////////////
+    //implemented
+    template <class T> class FutureState;
+    template <class T> class Future;
+    template <class T> class Promise;
+
+    //! Result type of fn called with the value of a Future<T>
+    template <class F, class T>
+    struct ContinuationResult
+    {
+        typedef typename std::invoke_result<typename std::decay<F>::type&, T>::type type;
+    };
+
+    template <class F>
+    struct ContinuationResult<F, void>
+    {
+        typedef typename std::invoke_result<typename std::decay<F>::type&>::type type;
+    };
+
+    //////////////////////////////////////////////////
+    //				class declarations				//
+    //////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @class	FutureState
+        @brief	State shared by a Promise and its Future
+        @note	Reference counted, freed by the last owner.
+    */
+    /****************************************/
+    template <class T>
+    class FutureState
+    {
+        friend class Future<T>;
+        friend class Promise<T>;
+    public:
+        enum{
+            STATE_PENDING,
+            STATE_CONTINUATION,	//!< Pending, a continuation is set
+            STATE_READY
+        };
+
+        typedef typename std::conditional<std::is_void<T>::value, char, T>::type Value;
+
+    public:
+        static FutureState *create()
+        {
+            void *memory = ObjectPool<FutureState>::allocate();
+            return new(memory) FutureState();
+        }
+
+        void addRef()
+        {
+            mNumRef.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release()
+        {
+            if(mNumRef.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+            this->~FutureState();
+            ObjectPool<FutureState>::deallocate(this);
+        }
+
+        bool isReady()const
+        {
+            return mState.load(std::memory_order_acquire) == STATE_READY;
+        }
+
+        void wait()
+        {
+            unsigned int state = mState.load(std::memory_order_acquire);
+            while(state != STATE_READY){
+                mState.wait(state, std::memory_order_acquire);
+                state = mState.load(std::memory_order_acquire);
+            }
+        }
+
+    private:
+        FutureState()
+        :mState(STATE_PENDING),
+        mNumRef(1)
+        {}
+
+        ~FutureState(){}
+
+        //! Publish the value or exception, wake waiters and run the continuation
+        void complete()
+        {
+            unsigned int prev = mState.exchange(STATE_READY, std::memory_order_acq_rel);
+            if(prev == STATE_CONTINUATION){
+                runContinuation();
+                return;
+            }
+            mState.notify_all();
+        }
+
+        //! The caller's reference moves to the continuation
+        template <class F>
+        void setContinuation(F &&fn)
+        {
+            mContinuation.assign(std::forward<F>(fn));
+
+            unsigned int expect = STATE_PENDING;
+            if(!mState.compare_exchange_strong(expect, STATE_CONTINUATION, std::memory_order_acq_rel, std::memory_order_acquire)){
+                runContinuation();
+            }
+        }
+
+        void runContinuation()
+        {
+            mContinuation();
+            mContinuation.reset();
+            release();
+        }
+
+    private:
+        std::atomic<unsigned int> mState;
+        std::atomic<int> mNumRef;
+
+        std::optional<Value> mValue;
+        std::exception_ptr mException;
+        InlineFunction mContinuation;
+    };
+
+    /****************************************/
+    /*!
+        @class	Future
+        @brief	Read side of a FutureState
+        @note	Move only. get() and then() consume the future,
+                it is invalid afterwards.
+    */
+    /****************************************/
+    template <class T>
+    class Future
+    {
+        friend class Promise<T>;
+    public:
+        Future()
+        :mState(NULL)
+        {}
+
+        Future(Future &&future)
+        :mState(future.mState)
+        {
+            future.mState = NULL;
+        }
+
+        Future &operator=(Future &&future)
+        {
+            if(this != &future){
+                reset();
+                mState = future.mState;
+                future.mState = NULL;
+            }
+            return *this;
+        }
+
+        ~Future(){reset();}
+
+    private:
+        explicit Future(FutureState<T> *state)
+        :mState(state)
+        {}
+
+        Future(const Future&);
+        Future &operator=(const Future&);
+
+    public:
+        bool isValid()const{return mState != NULL;}
+        bool isReady()const{return mState != NULL && mState->isReady();}
+
+        void wait()
+        {
+            mState->wait();
+        }
+
+        //! Wait and return the value, or rethrow the exception of the request
+        T get()
+        {
+            FutureState<T> *state = mState;
+            mState = NULL;
+            state->wait();
+
+            if(state->mException){
+                std::exception_ptr exception = state->mException;
+                state->release();
+                std::rethrow_exception(exception);
+            }
+
+            if constexpr (std::is_void<T>::value){
+                state->release();
+            }
+            else{
+                T ret(std::move(*state->mValue));
+                state->release();
+                return ret;
+            }
+        }
+
+        /****************************************/
+        /*!
+            @brief	Chain fn on the value
+            @note	fn takes T (nothing for void) and runs inline on
+                    the completing thread. An exception skips fn
+                    and is passed to the returned future.
+        */
+        /****************************************/
+        template <class F>
+        Future<typename ContinuationResult<F, T>::type> then(F &&fn)
+        {
+            typedef typename ContinuationResult<F, T>::type Result;
+
+            Promise<Result> promise;
+            Future<Result> ret = promise.getFuture();
+
+            FutureState<T> *state = mState;
+            mState = NULL;
+            state->setContinuation([state, promise = std::move(promise), fn = std::forward<F>(fn)]() mutable {
+                if(state->mException){
+                    promise.setException(state->mException);
+                }
+                else if constexpr (std::is_void<T>::value){
+                    promise.fulfill(fn);
+                }
+                else{
+                    promise.fulfill(fn, std::move(*state->mValue));
+                }
+            });
+            return ret;
+        }
+
+    private:
+        void reset()
+        {
+            if(mState == NULL) return;
+            mState->release();
+            mState = NULL;
+        }
+
+    private:
+        FutureState<T> *mState;
+    };
+
+    /****************************************/
+    /*!
+        @class	Promise
+        @brief	Write side of a FutureState
+        @note	Move only. A promise destroyed before it is
+                satisfied completes the future with
+                std::future_errc::broken_promise.
+    */
+    /****************************************/
+    template <class T>
+    class Promise
+    {
+    public:
+        Promise()
+        :mState(FutureState<T>::create())
+        {}
+
+        Promise(Promise &&promise)
+        :mState(promise.mState)
+        {
+            promise.mState = NULL;
+        }
+
+        Promise &operator=(Promise &&promise)
+        {
+            if(this != &promise){
+                abandon();
+                mState = promise.mState;
+                promise.mState = NULL;
+            }
+            return *this;
+        }
+
+        ~Promise(){abandon();}
+
+    private:
+        Promise(const Promise&);
+        Promise &operator=(const Promise&);
+
+    public:
+        //! Call once
+        Future<T> getFuture()
+        {
+            mState->addRef();
+            return Future<T>(mState);
+        }
+
+        template <class... Args>
+        void setValue(Args&&... args)
+        {
+            mState->mValue.emplace(std::forward<Args>(args)...);
+            finish();
+        }
+
+        void setException(std::exception_ptr exception)
+        {
+            mState->mException = exception;
+            finish();
+        }
+
+        //! Set the result of fn(args...), or the exception it throws
+        template <class F, class... Args>
+        void fulfill(F &fn, Args&&... args)
+        {
+            try{
+                if constexpr (std::is_void<T>::value){
+                    fn(std::forward<Args>(args)...);
+                    setValue();
+                }
+                else{
+                    setValue(fn(std::forward<Args>(args)...));
+                }
+            }
+            catch(...){
+                if(mState != NULL) setException(std::current_exception());
+            }
+        }
+
+    private:
+        void finish()
+        {
+            FutureState<T> *state = mState;
+            mState = NULL;
+            state->complete();
+            state->release();
+        }
+
+        void abandon()
+        {
+            if(mState == NULL) return;
+            setException(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+
+    private:
+        FutureState<T> *mState;
+    };
+
+}; //namespace SThread
+
+
+#endif //STHREAD_FUTURE_H
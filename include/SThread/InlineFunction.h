@@ -0,0 +1,145 @@
+/******************************************************************/
+/*!
+	@file	InlineFunction.h
+	@brief	Move-only callable with small-buffer storage
+	@note	Callables up to INLINE_SIZE bytes are kept inside the
+			object, larger ones on the heap. Used by FunctionRequest
+			and the continuations of Future.
+	@todo
+	@bug
+
+	@author	Naoto Nakamura
+	@date	Oct. 18, 2026
+*/
+/******************************************************************/
+
+#ifndef STHREAD_INLINEFUNCTION_H
+#define STHREAD_INLINEFUNCTION_H
+
+#include "SThread/Common.h"
+
+#include <new>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+
+namespace SThread{
+    //////////////////////////////////////////////////
+    //				forward declarations			//
+    //////////////////////////////////////////////////
+    //implemented
+    class InlineFunction;
+
+    //////////////////////////////////////////////////
+    //				class declarations				//
+    //////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @class	InlineFunction
+        @brief	Type-erased callable without arguments
+        @note	The callable returns void, or something
+                convertible to bool which is passed on
+                (void counts as TRUE).
+    */
+    /****************************************/
+    class InlineFunction
+    {
+    public:
+        static const size_t INLINE_SIZE = 48;
+
+    public:
+        InlineFunction()
+        :mInvoke(NULL),
+        mDestroy(NULL)
+        {}
+
+        template <class F>
+        explicit InlineFunction(F &&fn)
+        :mInvoke(NULL),
+        mDestroy(NULL)
+        {
+            assign(std::forward<F>(fn));
+        }
+
+        ~InlineFunction(){reset();}
+
+    private:
+        InlineFunction(const InlineFunction&);
+        InlineFunction &operator=(const InlineFunction&);
+
+    public:
+        template <class F>
+        void assign(F &&fn)
+        {
+            typedef typename std::decay<F>::type Function;
+            static_assert(std::is_invocable<Function&>::value, "InlineFunction needs a callable without arguments");
+
+            reset();
+            if constexpr (isInline<Function>()){
+                new(mStorage) Function(std::forward<F>(fn));
+            }
+            else{
+                *reinterpret_cast<Function**>(mStorage) = new Function(std::forward<F>(fn));
+            }
+            mInvoke = &invoke<Function>;
+            mDestroy = &destroy<Function>;
+        }
+
+        void reset()
+        {
+            if(mDestroy == NULL) return;
+            mDestroy(mStorage);
+            mInvoke = NULL;
+            mDestroy = NULL;
+        }
+
+        bool isEmpty()const{return mInvoke == NULL;}
+
+        bool operator()(){return mInvoke(mStorage);}
+
+        //! TRUE if a callable of type F is stored without allocation
+        template <class Function>
+        static constexpr bool isInline()
+        {
+            return sizeof(Function) <= INLINE_SIZE && alignof(Function) <= alignof(std::max_align_t);
+        }
+
+    private:
+        template <class Function>
+        static Function &get(void *storage)
+        {
+            if constexpr (isInline<Function>()) return *std::launder(reinterpret_cast<Function*>(storage));
+            else return **reinterpret_cast<Function**>(storage);
+        }
+
+        template <class Function>
+        static bool invoke(void *storage)
+        {
+            Function &fn = get<Function>(storage);
+            if constexpr (std::is_convertible<std::invoke_result_t<Function&>, bool>::value){
+                return fn() ? true : false;
+            }
+            else{
+                fn();
+                return true;
+            }
+        }
+
+        template <class Function>
+        static void destroy(void *storage)
+        {
+            if constexpr (isInline<Function>()) get<Function>(storage).~Function();
+            else delete &get<Function>(storage);
+        }
+
+    private:
+        bool (*mInvoke)(void *storage);
+        void (*mDestroy)(void *storage);
+        alignas(std::max_align_t) unsigned char mStorage[INLINE_SIZE];
+    };
+
+}; //namespace SThread
+
+
+#endif //STHREAD_INLINEFUNCTION_H
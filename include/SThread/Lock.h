@@ -27,6 +27,14 @@
 #endif
 #endif
 
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+#include <string.h>
+
+#include "SThread/Timer.h"
+#include "SThread/LockProfiler.h"
+
 
 namespace SThread{
 
@@ -36,7 +44,12 @@ namespace SThread{
     //implemented
     class Mutex;
     class SpinLock;
+    class BackoffSpinLock;
+    class TicketSpinLock;
+    class MCSLock;
+    class RWLock;
     class Condition;
+    struct WaitNode;
 
     //////////////////////////////////////////////////
     //				enum declarations				//
@@ -49,6 +62,8 @@ namespace SThread{
 
 #if defined USE_WINDOWSTHREAD_INTERFACE
     typedef HANDLE MutexHandle;
+#elif defined USE_FUTEX_INTERFACE
+    typedef std::atomic<int> MutexHandle;	//!< 0: unlocked, 1: locked, 2: locked with waiters
 #elif defined USE_PTHREAD_INTERFACE
     typedef pthread_mutex_t MutexHandle;
 #endif
@@ -67,10 +82,15 @@ namespace SThread{
     /****************************************/
     class ResourceLock
     {
+        friend class Condition;
     public:
         enum LOCK_TYPE{
             LOCK_MUTEX,
             LOCK_SPIN,
+            LOCK_BACKOFF_SPIN,
+            LOCK_TICKET,
+            LOCK_MCS,
+            LOCK_RW,
         };
 
     public:
@@ -80,11 +100,24 @@ namespace SThread{
     public:
         virtual bool isLocking() = 0;
 
-        virtual void lock() = 0;
+        virtual void lock(STHREAD_LOCK_SITE_PARAM) = 0;
         virtual void unlock() = 0;
 
+        //! Name in LockProfiler reports, name must outlive the lock
+        void setProfileName(const char *name){
+#if defined STHREAD_LOCK_PROFILE
+            mProfile.setName(name);
+#else
+            (void)name;
+#endif
+        }
+
     protected:
         LOCK_TYPE mType;	//<! Locker type
+
+#if defined STHREAD_LOCK_PROFILE
+        LockProfile mProfile;
+#endif
     };
 
     /****************************************/
@@ -103,6 +136,8 @@ namespace SThread{
             mType = LOCK_MUTEX;
 #if defined USE_WINDOWSTHREAD_INTERFACE
             mMutex = ::CreateMutex(NULL, FALSE, NULL);
+#elif defined USE_FUTEX_INTERFACE
+            mMutex.store(0, std::memory_order_relaxed);
 #elif defined USE_PTHREAD_INTERFACE
             pthread_mutex_init(&mMutex, NULL);
 #endif
@@ -112,6 +147,7 @@ namespace SThread{
             unlock();
 #if defined USE_WINDOWSTHREAD_INTERFACE
             ::CloseHandle(mMutex);
+#elif defined USE_FUTEX_INTERFACE
 #elif defined USE_PTHREAD_INTERFACE
             pthread_mutex_destroy(&mMutex);
 #endif
@@ -120,26 +156,82 @@ namespace SThread{
     public:
         virtual bool isLocking(){return mIsLocking;}
 
-        MutexHandle getMutexHandle(){return mMutex;}
+        MutexHandle *getMutexHandle(){return &mMutex;}
+
+        virtual void lock(STHREAD_LOCK_SITE_PARAM){
+#if defined STHREAD_LOCK_PROFILE
+            if(tryLockHandle()){
+                mProfile.acquired(site, 0, FALSE);
+                return;
+            }
+            unsigned long long waitBegin = Timer::now();
+            lockHandle();
+            mProfile.acquired(site, Timer::now() - waitBegin, TRUE);
+#else
+            lockHandle();
+#endif
+        }
+
+        virtual void unlock(){
+#if defined STHREAD_LOCK_PROFILE
+            mProfile.released();
+#endif
+            unlockHandle();
+        }
+
+    private:
+        friend class Condition;
 
-        virtual void lock(){
+        void lockHandle(){
 #if defined USE_WINDOWSTHREAD_INTERFACE
             ::WaitForSingleObject(mMutex, 0xffffffff);
+#elif defined USE_FUTEX_INTERFACE
+            int state = 0;
+            if(!mMutex.compare_exchange_strong(state, 1, std::memory_order_acquire)){
+                lockContended(state);
+            }
 #elif defined USE_PTHREAD_INTERFACE
             pthread_mutex_lock(&mMutex);
 #endif
             mIsLocking = TRUE;
         }
 
-        virtual void unlock(){
+#if defined STHREAD_LOCK_PROFILE
+        bool tryLockHandle(){
+#if defined USE_WINDOWSTHREAD_INTERFACE
+            if(::WaitForSingleObject(mMutex, 0) != WAIT_OBJECT_0) return FALSE;
+#elif defined USE_FUTEX_INTERFACE
+            int state = 0;
+            if(!mMutex.compare_exchange_strong(state, 1, std::memory_order_acquire)) return FALSE;
+#elif defined USE_PTHREAD_INTERFACE
+            if(pthread_mutex_trylock(&mMutex) != 0) return FALSE;
+#endif
+            mIsLocking = TRUE;
+            return TRUE;
+        }
+#endif
+
+        void unlockHandle(){
 #if defined USE_WINDOWSTHREAD_INTERFACE
             if(::ReleaseMutex(mMutex) != 0 && mIsLocking)mIsLocking = FALSE;
+#elif defined USE_FUTEX_INTERFACE
+            mIsLocking = FALSE;
+            if(mMutex.fetch_sub(1, std::memory_order_release) != 1){
+                unlockContended();
+            }
+            return;
 #elif defined USE_PTHREAD_INTERFACE
             pthread_mutex_unlock(&mMutex);
 #endif
             mIsLocking = FALSE;
         }
 
+#if defined USE_FUTEX_INTERFACE
+    private:
+        void lockContended(int state);
+        void unlockContended();
+#endif
+
     private:
         bool mIsLocking;			//<! Flog describing if object i locking
 
@@ -169,16 +261,23 @@ namespace SThread{
         bool tryLock()
         {
 #if defined COMPILER_MSVC
-            long ret = InterlockedExchange(&mIsLocked, 1 );
+            long ret = InterlockedExchange(mIsLocked.get(), 1 );
             MemoryBarrier();
             return ret == 0;
 #elif defined COMPILER_GCC
-            return __sync_bool_compare_and_swap(&mIsLocked, 0, 1);
+            return __sync_bool_compare_and_swap(mIsLocked.get(), 0, 1);
 #endif
         }
 
-        virtual void lock()
+        virtual void lock(STHREAD_LOCK_SITE_PARAM)
         {
+#if defined STHREAD_LOCK_PROFILE
+            if(tryLock()){
+                mProfile.acquired(site, 0, FALSE);
+                return;
+            }
+            unsigned long long waitBegin = Timer::now();
+#endif
             while(!tryLock()){
 #if defined COMPILER_MSVC
                 Sleep(0);
@@ -186,23 +285,247 @@ namespace SThread{
                 sched_yield();
 #endif
             }
+#if defined STHREAD_LOCK_PROFILE
+            mProfile.acquired(site, Timer::now() - waitBegin, TRUE);
+#endif
         }
 
         virtual void unlock()
         {
+#if defined STHREAD_LOCK_PROFILE
+            mProfile.released();
+#endif
 #if defined COMPILER_MSVC
             MemoryBarrier();
 #elif defined COMPILER_GCC
 #endif
-            *const_cast< long volatile* >( &mIsLocked ) = 0;
+            *const_cast< long volatile* >( mIsLocked.get() ) = 0;
         }
 
-        virtual bool isLocking(){return mIsLocked != 0;}
+        virtual bool isLocking(){return *mIsLocked != 0;}
 
     private:
-        long mIsLocked;
+        CachePadded<long> mIsLocked;	//!< Own line, apart from the data the lock guards
 
     };
+
+    /****************************************/
+    /*!
+        @class BackoffSpinLock
+        @brief Test-and-test-and-set spin lock with exponential backoff
+        @note  Waiters spin on a plain load so the line stays shared
+               while the lock is held, and back off exponentially
+               after each failed exchange.
+    */
+    /****************************************/
+    class BackoffSpinLock : public ResourceLock
+    {
+    public:
+        static const int MIN_BACKOFF = 4;
+        static const int MAX_BACKOFF = 1024;
+
+    public:
+        BackoffSpinLock()
+            :ResourceLock(), mIsLocked(0){
+            mType = LOCK_BACKOFF_SPIN;
+        }
+
+        virtual ~BackoffSpinLock(){}
+
+    public:
+        bool tryLock()
+        {
+            return mIsLocked.load(std::memory_order_relaxed) == 0 &&
+                mIsLocked.exchange(1, std::memory_order_acquire) == 0;
+        }
+
+        virtual void lock(STHREAD_LOCK_SITE_PARAM)
+        {
+            int backoff = MIN_BACKOFF;
+            while(!tryLock()){
+                for(int i = 0; i < backoff; i++) CPU_PAUSE();
+
+                if(backoff < MAX_BACKOFF){
+                    backoff <<= 1;
+                }
+                else{
+#if defined COMPILER_MSVC
+                    Sleep(0);
+#elif defined COMPILER_GCC
+                    sched_yield();
+#endif
+                }
+            }
+        }
+
+        virtual void unlock()
+        {
+            mIsLocked.store(0, std::memory_order_release);
+        }
+
+        virtual bool isLocking(){return mIsLocked.load(std::memory_order_relaxed) != 0;}
+
+    private:
+        std::atomic<int> mIsLocked;
+    };
+
+    /****************************************/
+    /*!
+        @class TicketSpinLock
+        @brief FIFO spin lock
+        @note  Waiters back off in proportion to their
+               distance from the ticket being served.
+    */
+    /****************************************/
+    class TicketSpinLock : public ResourceLock
+    {
+    public:
+        static const int SPIN_BEFORE_YIELD = 1024;
+
+    public:
+        TicketSpinLock()
+            :ResourceLock(), mNextTicket(0), mNowServing(0){
+            mType = LOCK_TICKET;
+        }
+
+        virtual ~TicketSpinLock(){}
+
+    public:
+        bool tryLock()
+        {
+            unsigned int serving = mNowServing.load(std::memory_order_acquire);
+            unsigned int expect = serving;
+            return mNextTicket.compare_exchange_strong(expect, serving + 1, std::memory_order_acquire);
+        }
+
+        virtual void lock(STHREAD_LOCK_SITE_PARAM)
+        {
+            unsigned int ticket = mNextTicket.fetch_add(1, std::memory_order_relaxed);
+            int spin = 0;
+            while(1){
+                unsigned int serving = mNowServing.load(std::memory_order_acquire);
+                if(serving == ticket) return;
+
+                unsigned int distance = ticket - serving;
+                for(unsigned int i = 0; i < distance * 8; i++) CPU_PAUSE();
+
+                spin += distance * 8;
+                if(spin > SPIN_BEFORE_YIELD){
+                    spin = 0;
+#if defined COMPILER_MSVC
+                    Sleep(0);
+#elif defined COMPILER_GCC
+                    sched_yield();
+#endif
+                }
+            }
+        }
+
+        virtual void unlock()
+        {
+            mNowServing.store(mNowServing.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        virtual bool isLocking(){
+            return mNextTicket.load(std::memory_order_relaxed) != mNowServing.load(std::memory_order_relaxed);
+        }
+
+    private:
+        ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) std::atomic<unsigned int> mNextTicket;
+        ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) std::atomic<unsigned int> mNowServing;
+    };
+
+    /****************************************/
+    /*!
+        @class MCSLock
+        @brief Queue lock where each waiter spins on its own node
+        @note  lock()/unlock() take a node from a per-thread
+               pool, so they must be called from the same thread.
+               lock(node)/unlock(node) let the caller own the node.
+    */
+    /****************************************/
+    class MCSLock : public ResourceLock
+    {
+    public:
+        static const int SPIN_BEFORE_YIELD = 1024;
+
+        struct ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) Node
+        {
+            std::atomic<Node*> next;
+            std::atomic<bool> isWaiting;
+            Node *poolNext;			//!< Link in the per-thread node pool
+        };
+
+    public:
+        MCSLock()
+            :ResourceLock(), mTail(NULL), mOwner(NULL){
+            mType = LOCK_MCS;
+        }
+
+        virtual ~MCSLock(){}
+
+    public:
+        void lock(Node *node)
+        {
+            node->next.store(NULL, std::memory_order_relaxed);
+            node->isWaiting.store(TRUE, std::memory_order_relaxed);
+
+            Node *prev = mTail.exchange(node, std::memory_order_acq_rel);
+            if(prev != NULL){
+                prev->next.store(node, std::memory_order_release);
+
+                int spin = 0;
+                while(node->isWaiting.load(std::memory_order_acquire)){
+                    CPU_PAUSE();
+                    if(++spin > SPIN_BEFORE_YIELD){
+                        spin = 0;
+#if defined COMPILER_MSVC
+                        Sleep(0);
+#elif defined COMPILER_GCC
+                        sched_yield();
+#endif
+                    }
+                }
+            }
+        }
+
+        void unlock(Node *node)
+        {
+            Node *next = node->next.load(std::memory_order_acquire);
+            if(next == NULL){
+                Node *expect = node;
+                if(mTail.compare_exchange_strong(expect, NULL, std::memory_order_release, std::memory_order_relaxed)) return;
+
+                //a successor is linking itself
+                while((next = node->next.load(std::memory_order_acquire)) == NULL) CPU_PAUSE();
+            }
+            next->isWaiting.store(FALSE, std::memory_order_release);
+        }
+
+        virtual void lock(STHREAD_LOCK_SITE_PARAM);
+        virtual void unlock();
+
+        virtual bool isLocking(){return mTail.load(std::memory_order_relaxed) != NULL;}
+
+    private:
+        std::atomic<Node*> mTail;
+        Node *mOwner;				//!< Node of the holder, touched by the holder only
+    };
+    /****************************************/
+    /*!
+        @struct	WaitNode
+        @brief	Intrusive waiter woken by a callback
+        @note	Lets a coroutine wait on a Condition or a Thread
+                without a blocked thread. wake runs on the waking
+                thread, the node may be gone after it returns.
+    */
+    /****************************************/
+    struct WaitNode
+    {
+        WaitNode *next;
+        void (*wake)(WaitNode *node);
+    };
+
     /****************************************/
     /*!
         @class	Condition
@@ -215,7 +538,10 @@ namespace SThread{
     class Condition : public Mutex
     {
     public:
-        Condition():Mutex()
+        Condition():Mutex(),
+            mWaiterHead(NULL),
+            mWaiterTail(NULL),
+            mHasWaiter(FALSE)
             {
 #if defined USE_WINDOWSTHREAD_INTERFACE
                 mNumWaiting = 0;
@@ -224,13 +550,26 @@ namespace SThread{
                 mNumWake = 0;
                 mSemaphore = ::CreateSemaphore(NULL, 0, LONG_MAX, NULL);
                 ::InitializeCriticalSection(&mCriticalSection);
+#elif defined USE_FUTEX_INTERFACE
+            mSequence.store(0, std::memory_order_relaxed);
+            mNumWaiter.store(0, std::memory_order_relaxed);
 #elif defined USE_PTHREAD_INTERFACE
+#if defined OS_MACOSX || defined OS_IPHONE
             pthread_cond_init(&mCondition, NULL);
+#else
+            //deadlines must not move with the wall clock
+            pthread_condattr_t attr;
+            pthread_condattr_init(&attr);
+            pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+            pthread_cond_init(&mCondition, &attr);
+            pthread_condattr_destroy(&attr);
+#endif
 #endif
 
         }
         virtual ~Condition(){
 #if defined USE_WINDOWSTHREAD_INTERFACE
+#elif defined USE_FUTEX_INTERFACE
 #elif defined USE_PTHREAD_INTERFACE
             pthread_cond_destroy(&mCondition);
 #endif
@@ -239,7 +578,34 @@ namespace SThread{
     public:
 
         void wait(unsigned long time = 0xffffff, Mutex *mutex = NULL){timedwait(time, mutex);}
-        ResumeStatus timedwait(unsigned long timeoutMilliSec, Mutex *mutex = NULL);
+
+        ResumeStatus timedwait(unsigned long timeoutMilliSec, Mutex *mutex = NULL){
+            return waitUntilNano(Timer::getMonotonicNanoTime() + (unsigned long long)timeoutMilliSec * 1000000ULL, mutex);
+        }
+
+        template <class Rep, class Period>
+        ResumeStatus waitFor(const std::chrono::duration<Rep, Period> &timeout, Mutex *mutex = NULL){
+            return waitUntilNano(Timer::getMonotonicNanoTime() + Timer::toNanoTime(timeout), mutex);
+        }
+
+        template <class Clock, class Duration>
+        ResumeStatus waitUntil(const std::chrono::time_point<Clock, Duration> &deadline, Mutex *mutex = NULL){
+            return waitUntilNano(Timer::toMonotonicNanoTime(deadline), mutex);
+        }
+
+        //! Wait until the deadline on the Timer::getMonotonicNanoTime() clock
+        ResumeStatus waitUntilNano(unsigned long long deadlineNanoSec, Mutex *mutex = NULL){
+#if defined STHREAD_LOCK_PROFILE
+            //the hold pauses while the mutex is given up
+            Mutex *locker = mutex != NULL ? mutex : this;
+            locker->mProfile.released();
+            ResumeStatus ret = waitHandle(deadlineNanoSec, mutex);
+            locker->mProfile.reacquired();
+            return ret;
+#else
+            return waitHandle(deadlineNanoSec, mutex);
+#endif
+        }
 
         void signal(){
 #if defined USE_WINDOWSTHREAD_INTERFACE
@@ -255,9 +621,13 @@ namespace SThread{
             if (wake) {
                 ::ReleaseSemaphore(mSemaphore, 1, NULL);
             }
+#elif defined USE_FUTEX_INTERFACE
+            mSequence.fetch_add(1, std::memory_order_seq_cst);
+            wake(FALSE);
 #elif defined USE_PTHREAD_INTERFACE
             pthread_cond_signal(&mCondition);
 #endif
+            if(mHasWaiter.load(std::memory_order_acquire)) wakeWaiter(FALSE);
         }
 
         void signalAll(){
@@ -276,12 +646,34 @@ namespace SThread{
             if (numWake) {
                 ::ReleaseSemaphore(mSemaphore, numWake, NULL);
             }
+#elif defined USE_FUTEX_INTERFACE
+            mSequence.fetch_add(1, std::memory_order_seq_cst);
+            wake(TRUE);
 #elif defined USE_PTHREAD_INTERFACE
             pthread_cond_broadcast(&mCondition);
 #endif
-
+            if(mHasWaiter.load(std::memory_order_acquire)) wakeWaiter(TRUE);
         }
 
+        /****************************************/
+        /*!
+            @brief	Queue an asynchronous waiter
+            @note	Add it while holding the lock the waiting
+                    thread would hold, then unlock. signal()
+                    wakes the oldest node as well as a blocked
+                    thread, signalAll() wakes every node.
+        */
+        /****************************************/
+        void addWaiter(WaitNode *node);
+
+    private:
+        ResumeStatus waitHandle(unsigned long long deadlineNanoSec, Mutex *mutex);
+        void wakeWaiter(bool isAll);
+
+#if defined USE_FUTEX_INTERFACE
+        void wake(bool isAll);
+#endif
+
     private:
 #if defined USE_WINDOWSTHREAD_INTERFACE
         HANDLE mSemaphore;					//<! Semaphore for manage threads
@@ -289,19 +681,35 @@ namespace SThread{
         unsigned long mNumWaiting;			//<! The number of waiting threads
         unsigned long mGeneration;			//<! The generation of blocking
         unsigned long mNumWake;				//<! The number of threads sending signal
+#elif defined USE_FUTEX_INTERFACE
+        std::atomic<int> mSequence;				//<! Bumped by every signal, waiters sleep on it
+        std::atomic<int> mNumWaiter;				//<! Threads between registering and leaving a wait
 #elif defined USE_PTHREAD_INTERFACE
         pthread_cond_t mCondition;		//<! Condition descriptor
 #endif
+
+        SpinLock mWaiterLock;
+        WaitNode *mWaiterHead;				//<! Asynchronous waiters, FIFO
+        WaitNode *mWaiterTail;
+        std::atomic<bool> mHasWaiter;		//<! Skips mWaiterLock in signal() without waiters
     };
 
     class LockHolder
     {
     public:
+#if defined STHREAD_LOCK_PROFILE
+        LockHolder(ResourceLock *locker, const LockSite &site = LockSite::current())
+        :mLocker(locker)
+        {
+            mLocker->lock(site);
+        }
+#else
         LockHolder(ResourceLock *locker)
         :mLocker(locker)
         {
             mLocker->lock();
         }
+#endif
         
         ~LockHolder()
         {
@@ -313,6 +721,236 @@ namespace SThread{
 
     };
 
+    /****************************************/
+    /*!
+        @class RWLock
+        @brief Writer-preferring reader-writer spin lock
+        @note  Readers count themselves in one of NUM_READER_SLOT
+               cache-line-padded slots chosen per thread, so
+               concurrent readers do not write a shared line.
+               A writer raises its flag first, which turns new
+               readers away, then waits for every slot to drain.
+               lock()/unlock() are the exclusive (writer) side.
+    */
+    /****************************************/
+    class RWLock : public ResourceLock
+    {
+    public:
+        static const int NUM_READER_SLOT = 32;
+        static const unsigned int SPIN_BEFORE_YIELD = 1024;
+
+    public:
+        RWLock()
+            :ResourceLock(), mIsWriting(0){
+            mType = LOCK_RW;
+            for(int i = 0; i < NUM_READER_SLOT; i++) mReaders[i].count.store(0, std::memory_order_relaxed);
+        }
+
+        virtual ~RWLock(){}
+
+    public:
+        void lockShared()
+        {
+            ReaderSlot &slot = mReaders[getReaderSlot()];
+            while(1){
+                slot.count.fetch_add(1, std::memory_order_seq_cst);
+                if(mIsWriting.load(std::memory_order_seq_cst) == 0) return;
+
+                //let the writer go first
+                slot.count.fetch_sub(1, std::memory_order_relaxed);
+                unsigned int spin = 0;
+                while(mIsWriting.load(std::memory_order_relaxed) != 0) spinWait(spin);
+            }
+        }
+
+        void unlockShared()
+        {
+            mReaders[getReaderSlot()].count.fetch_sub(1, std::memory_order_release);
+        }
+
+        virtual void lock(STHREAD_LOCK_SITE_PARAM)
+        {
+            unsigned int spin = 0;
+            int expect = 0;
+            while(!mIsWriting.compare_exchange_weak(expect, 1, std::memory_order_seq_cst)){
+                expect = 0;
+                spinWait(spin);
+            }
+
+            for(int i = 0; i < NUM_READER_SLOT; i++){
+                while(mReaders[i].count.load(std::memory_order_acquire) != 0) spinWait(spin);
+            }
+        }
+
+        virtual void unlock()
+        {
+            mIsWriting.store(0, std::memory_order_release);
+        }
+
+        virtual bool isLocking(){
+            if(mIsWriting.load(std::memory_order_relaxed) != 0) return TRUE;
+            for(int i = 0; i < NUM_READER_SLOT; i++){
+                if(mReaders[i].count.load(std::memory_order_relaxed) != 0) return TRUE;
+            }
+            return FALSE;
+        }
+
+    private:
+        static int getReaderSlot();
+
+        //! Unsigned, a signed count trips -Wstrict-overflow where it is inlined
+        static void spinWait(unsigned int &spin)
+        {
+            CPU_PAUSE();
+            if(++spin > SPIN_BEFORE_YIELD){
+                spin = 0;
+#if defined COMPILER_MSVC
+                Sleep(0);
+#elif defined COMPILER_GCC
+                sched_yield();
+#endif
+            }
+        }
+
+    private:
+        struct ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) ReaderSlot
+        {
+            std::atomic<int> count;
+        };
+
+        ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) std::atomic<int> mIsWriting;
+        ReaderSlot mReaders[NUM_READER_SLOT];
+    };
+
+    class ReadLockHolder
+    {
+    public:
+        ReadLockHolder(RWLock *locker)
+        :mLocker(locker)
+        {
+            mLocker->lockShared();
+        }
+
+        ~ReadLockHolder()
+        {
+            mLocker->unlockShared();
+        }
+
+    private:
+        RWLock *mLocker;
+
+    };
+
+    class WriteLockHolder
+    {
+    public:
+        WriteLockHolder(RWLock *locker)
+        :mLocker(locker)
+        {
+            mLocker->lock();
+        }
+
+        ~WriteLockHolder()
+        {
+            mLocker->unlock();
+        }
+
+    private:
+        RWLock *mLocker;
+
+    };
+
+    /****************************************/
+    /*!
+        @class SeqLock
+        @brief Sequence lock for small POD snapshots
+        @note  Readers copy the value and retry if a writer
+               was active, so they never write shared memory.
+               Writers are serialized by the odd sequence.
+    */
+    /****************************************/
+    template <typename T>
+    class SeqLock
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "SeqLock copies T with memcpy");
+
+    public:
+        SeqLock():mSequence(0){memset(&mValue, 0, sizeof(T));}
+        explicit SeqLock(const T &value):mSequence(0){memcpy(&mValue, &value, sizeof(T));}
+
+    public:
+        T read() const
+        {
+            T ret;
+            unsigned int begin, end;
+            do{
+                begin = mSequence.load(std::memory_order_acquire);
+                while(begin & 1){
+                    CPU_PAUSE();
+                    begin = mSequence.load(std::memory_order_acquire);
+                }
+                memcpy(&ret, &mValue, sizeof(T));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                end = mSequence.load(std::memory_order_relaxed);
+            }while(begin != end);
+            return ret;
+        }
+
+        void write(const T &value)
+        {
+            T *target = beginWrite();
+            memcpy(target, &value, sizeof(T));
+            endWrite();
+        }
+
+        //! Enter the write section and return the value to modify
+        T *beginWrite()
+        {
+            unsigned int seq = mSequence.load(std::memory_order_relaxed);
+            while((seq & 1) || !mSequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire)){
+                CPU_PAUSE();
+                seq = mSequence.load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+            return &mValue;
+        }
+
+        void endWrite()
+        {
+            mSequence.fetch_add(1, std::memory_order_release);
+        }
+
+        unsigned int getSequence() const {return mSequence.load(std::memory_order_acquire);}
+
+    private:
+        std::atomic<unsigned int> mSequence;
+        T mValue;
+    };
+
+    template <typename T>
+    class SeqLockWriteHolder
+    {
+    public:
+        SeqLockWriteHolder(SeqLock<T> *locker)
+        :mLocker(locker)
+        {
+            mValue = mLocker->beginWrite();
+        }
+
+        ~SeqLockWriteHolder()
+        {
+            mLocker->endWrite();
+        }
+
+        T *get(){return mValue;}
+        T *operator->(){return mValue;}
+
+    private:
+        SeqLock<T> *mLocker;
+        T *mValue;
+
+    };
+
 }; //namespace SThread
 
 #endif //STHREAD_LOCK_H
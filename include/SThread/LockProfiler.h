@@ -0,0 +1,206 @@
+/******************************************************************/
+/*!
+	@file	LockProfiler.h
+	@brief	Contention profile of Mutex, SpinLock and Condition
+	@note	Built only with STHREAD_LOCK_PROFILE (meson option
+			lock_profile), otherwise the locks have neither extra
+			members nor extra code. The define changes the layout
+			and the lock() signature of every ResourceLock, so the
+			library and its users must agree on it.
+
+			Acquisitions are keyed by the lock name
+			(ResourceLock::setProfileName) and the call site of
+			lock(). Wait time is the time spent blocked in lock(),
+			hold time runs from lock() to unlock() excluding
+			Condition waits.
+	@todo
+	@bug
+
+	@author	Naoto Nakamura
+	@date	Oct. 18, 2026
+*/
+/******************************************************************/
+
+#ifndef STHREAD_LOCKPROFILER_H
+#define STHREAD_LOCKPROFILER_H
+
+#include "SThread/Common.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#if defined STHREAD_LOCK_PROFILE
+#include <source_location>
+#endif
+
+#include "SThread/Timer.h"
+
+
+#if defined STHREAD_LOCK_PROFILE
+//! Parameter of lock() declarations, the caller's location by default
+#define STHREAD_LOCK_SITE_PARAM [[maybe_unused]] const SThread::LockSite &site = SThread::LockSite::current()
+//! Parameter of out-of-line lock() definitions
+#define STHREAD_LOCK_SITE_ARG [[maybe_unused]] const SThread::LockSite &site
+#else
+#define STHREAD_LOCK_SITE_PARAM
+#define STHREAD_LOCK_SITE_ARG
+#endif
+
+
+namespace SThread{
+    //////////////////////////////////////////////////
+    //				forward declarations			//
+    //////////////////////////////////////////////////
+    //implemented
+    struct LockProfileRecord;
+    class LockProfiler;
+#if defined STHREAD_LOCK_PROFILE
+    class LockProfile;
+
+    typedef std::source_location LockSite;
+#endif
+
+    //////////////////////////////////////////////////
+    //				class declarations				//
+    //////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @struct	LockProfileRecord
+        @brief	Counters of one lock name and call site
+        @note	Times are nanoseconds.
+    */
+    /****************************************/
+    struct LockProfileRecord
+    {
+        std::string name;			//!< Empty for unnamed locks
+        std::string file;
+        std::string function;
+        unsigned int line;
+
+        unsigned long long numAcquire;
+        unsigned long long numContended;	//!< Acquisitions which had to wait
+        unsigned long long waitTime;
+        unsigned long long maxWaitTime;
+        unsigned long long holdTime;
+    };
+
+    /****************************************/
+    /*!
+        @class	LockProfiler
+        @brief	Aggregated contention report
+        @note	Available in every build; without
+                STHREAD_LOCK_PROFILE it has no records.
+    */
+    /****************************************/
+    class LockProfiler
+    {
+    public:
+        static bool isEnabled()
+        {
+#if defined STHREAD_LOCK_PROFILE
+            return TRUE;
+#else
+            return FALSE;
+#endif
+        }
+
+        //! Records sorted by total wait time, longest first
+        static std::vector<LockProfileRecord> getRecords();
+
+        static void report(FILE *fp = stdout);
+
+        //! Reset the counters, sites stay registered
+        static void clear();
+
+#if defined STHREAD_LOCK_PROFILE
+    public:
+        struct Entry
+        {
+            const char *name;
+            const char *file;
+            const char *function;
+            unsigned int line;
+
+            std::atomic<unsigned long long> numAcquire;
+            std::atomic<unsigned long long> numContended;
+            std::atomic<unsigned long long> waitTime;
+            std::atomic<unsigned long long> maxWaitTime;
+            std::atomic<unsigned long long> holdTime;
+        };
+
+        //! Find or register the entry of name and site
+        static Entry *getEntry(const char *name, const LockSite &site);
+#endif
+    };
+
+#if defined STHREAD_LOCK_PROFILE
+    /****************************************/
+    /*!
+        @class	LockProfile
+        @brief	Profiling state embedded in a ResourceLock
+        @note	Called by the holder of the lock only, so
+                the state needs no synchronization; entries
+                are shared between locks and updated atomically.
+    */
+    /****************************************/
+    class LockProfile
+    {
+    public:
+        LockProfile()
+        :mName(NULL), mEntry(NULL), mHoldEntry(NULL), mHoldBegin(0){}
+
+    public:
+        //! name must outlive the lock, a string literal usually
+        void setName(const char *name)
+        {
+            mName = name;
+            mEntry = NULL;
+        }
+
+        void acquired(const LockSite &site, const unsigned long long waitTime, const bool isContended)
+        {
+            if(mEntry == NULL || mEntry->line != site.line() || mEntry->file != site.file_name() || mEntry->function != site.function_name()){
+                mEntry = LockProfiler::getEntry(mName, site);
+            }
+
+            mEntry->numAcquire.fetch_add(1, std::memory_order_relaxed);
+            if(isContended){
+                mEntry->numContended.fetch_add(1, std::memory_order_relaxed);
+                mEntry->waitTime.fetch_add(waitTime, std::memory_order_relaxed);
+
+                unsigned long long current = mEntry->maxWaitTime.load(std::memory_order_relaxed);
+                while(waitTime > current && !mEntry->maxWaitTime.compare_exchange_weak(current, waitTime, std::memory_order_relaxed));
+            }
+
+            mHoldEntry = mEntry;
+            mHoldBegin = Timer::now();
+        }
+
+        void released()
+        {
+            if(mHoldEntry == NULL) return;
+            mHoldEntry->holdTime.fetch_add(Timer::now() - mHoldBegin, std::memory_order_relaxed);
+            mHoldEntry = NULL;
+        }
+
+        //! The lock is taken back after a Condition wait
+        void reacquired()
+        {
+            mHoldEntry = mEntry;
+            mHoldBegin = Timer::now();
+        }
+
+    private:
+        const char *mName;
+        LockProfiler::Entry *mEntry;		//!< Entry of the last call site
+        LockProfiler::Entry *mHoldEntry;	//!< Entry charged with the current hold
+        unsigned long long mHoldBegin;
+    };
+#endif
+
+}; //namespace SThread
+
+
+#endif //STHREAD_LOCKPROFILER_H
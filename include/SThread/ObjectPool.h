@@ -0,0 +1,237 @@
+/******************************************************************/
+/*!
+	@file	ObjectPool.h
+	@brief	Thread-caching pool of fixed-size objects
+	@note	Each thread keeps a free list per type. Memory freed on
+			a thread other than the one which allocated it (the
+			consumer of a producer's requests) is gathered in that
+			thread's list and handed back to a shared stack in
+			batches, so a lock is taken once per BATCH_SIZE objects.
+	@todo
+	@bug
+
+	@author	Naoto Nakamura
+	@date	Oct. 18, 2026
+*/
+/******************************************************************/
+
+#ifndef STHREAD_OBJECTPOOL_H
+#define STHREAD_OBJECTPOOL_H
+
+#include "SThread/Common.h"
+
+#include <new>
+
+#include "SThread/Lock.h"
+
+
+namespace SThread{
+    //////////////////////////////////////////////////
+    //				forward declarations			//
+    //////////////////////////////////////////////////
+    //implemented
+    template <class T> class ObjectPool;
+
+    //////////////////////////////////////////////////
+    //				class declarations				//
+    //////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @class	ObjectPool
+        @brief	Raw storage for objects of type T
+        @note	allocate() returns uninitialized memory of
+                sizeof(T) obtained by ::operator new, so an object
+                built in it may still be released with delete.
+                The shared stack keeps at most MAX_SHARED_BATCH
+                batches, the rest is returned to the heap.
+                Without thread local storage every call goes
+                to the heap.
+    */
+    /****************************************/
+    template <class T>
+    class ObjectPool
+    {
+    public:
+        static const int BATCH_SIZE = 32;			//!< Objects moved to/from the shared stack at once
+        static const int MAX_SHARED_BATCH = 256;
+
+    private:
+        struct Node
+        {
+            Node *next;			//!< Next object in the batch
+            Node *nextBatch;	//!< Next batch, valid on the first node of a batch
+        };
+
+        static_assert(sizeof(T) >= sizeof(Node), "ObjectPool needs objects of at least two pointers");
+
+        //! Batches shared by all threads
+        struct Shared
+        {
+            SpinLock locker;
+            Node *batches;
+            int numBatch;
+
+            Shared():batches(NULL), numBatch(0){
+                locker.setProfileName("ObjectPool::mLocker");
+            }
+        };
+
+#if ENABLED_THREADLOCALSTORAGE
+        //! Free list of one thread, handed back when the thread exits
+        struct LocalCache
+        {
+            Node *full;			//!< A complete batch kept for the next allocations
+            Node *current;		//!< Batch being filled or drained
+            int numCurrent;
+
+            LocalCache():full(NULL), current(NULL), numCurrent(0){}
+            ~LocalCache(){
+                if(full != NULL) pushBatch(full);
+                if(current != NULL) releaseNodes(current);
+            }
+        };
+#endif
+
+    public:
+        static void *allocate()
+        {
+#if ENABLED_THREADLOCALSTORAGE
+            LocalCache &cache = getCache();
+            if(cache.current == NULL){
+                if(cache.full != NULL){
+                    cache.current = cache.full;
+                    cache.full = NULL;
+                }
+                else{
+                    cache.current = popBatch();
+                    if(cache.current == NULL) return allocateMemory();
+                }
+                cache.numCurrent = BATCH_SIZE;
+            }
+
+            Node *node = cache.current;
+            cache.current = node->next;
+            cache.numCurrent--;
+            return node;
+#else
+            return allocateMemory();
+#endif
+        }
+
+        static void deallocate(void *memory)
+        {
+            if(memory == NULL) return;
+            Node *node = static_cast<Node*>(memory);
+
+#if ENABLED_THREADLOCALSTORAGE
+            LocalCache &cache = getCache();
+            if(cache.numCurrent >= BATCH_SIZE){
+                if(cache.full != NULL) pushBatch(cache.full);
+                cache.full = cache.current;
+                cache.current = NULL;
+                cache.numCurrent = 0;
+            }
+
+            node->next = cache.current;
+            cache.current = node;
+            cache.numCurrent++;
+#else
+            freeMemory(node);
+#endif
+        }
+
+        //! Return the shared batches to the heap
+        static void shrink()
+        {
+            Shared &shared = getShared();
+            shared.locker.lock();
+            Node *batches = shared.batches;
+            shared.batches = NULL;
+            shared.numBatch = 0;
+            shared.locker.unlock();
+
+            while(batches != NULL){
+                Node *next = batches->nextBatch;
+                releaseNodes(batches);
+                batches = next;
+            }
+        }
+
+    private:
+        static void *allocateMemory()
+        {
+            if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__){
+                return ::operator new(sizeof(T), std::align_val_t(alignof(T)));
+            }
+            else{
+                return ::operator new(sizeof(T));
+            }
+        }
+
+        static void freeMemory(void *memory)
+        {
+            if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__){
+                ::operator delete(memory, std::align_val_t(alignof(T)));
+            }
+            else{
+                ::operator delete(memory);
+            }
+        }
+
+        static void releaseNodes(Node *node)
+        {
+            while(node != NULL){
+                Node *next = node->next;
+                freeMemory(node);
+                node = next;
+            }
+        }
+
+        //! Shared state is never destroyed, threads may exit after static destruction
+        static Shared &getShared()
+        {
+            static Shared *shared = new Shared();
+            return *shared;
+        }
+
+#if ENABLED_THREADLOCALSTORAGE
+        static LocalCache &getCache()
+        {
+            static thread_local LocalCache cache;
+            return cache;
+        }
+#endif
+
+        static void pushBatch(Node *batch)
+        {
+            Shared &shared = getShared();
+            shared.locker.lock();
+            if(shared.numBatch < MAX_SHARED_BATCH){
+                batch->nextBatch = shared.batches;
+                shared.batches = batch;
+                shared.numBatch++;
+                batch = NULL;
+            }
+            shared.locker.unlock();
+
+            if(batch != NULL) releaseNodes(batch);
+        }
+
+        static Node *popBatch()
+        {
+            Shared &shared = getShared();
+            shared.locker.lock();
+            Node *batch = shared.batches;
+            if(batch != NULL){
+                shared.batches = batch->nextBatch;
+                shared.numBatch--;
+            }
+            shared.locker.unlock();
+            return batch;
+        }
+    };
+
+}; //namespace SThread
+
+
+#endif //STHREAD_OBJECTPOOL_H
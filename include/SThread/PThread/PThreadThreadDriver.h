@@ -37,6 +37,8 @@ namespace SThread{
     public:
         PThreadThreadDriver(Thread *thread)
         :ThreadDriver(thread),
+         mJoinHandle(0),
+         mIsReaped(TRUE),
          mBindIndex(-1)
         {
         }
@@ -51,7 +53,7 @@ namespace SThread{
 
         virtual void shutdownThread();
         
-        virtual ResumeStatus join(unsigned long timeupMillSec);
+        virtual ResumeStatus joinUntil(unsigned long long deadlineNanoSec);
         
     private:
         static void *_staticRun(void *instance);
@@ -60,6 +62,7 @@ namespace SThread{
         
         ThreadHandle mJoinHandle;
         Condition mJoinCondition;
+        bool mIsReaped;		//!< Joined or detached, the handle must not be used again
 
         int mBindIndex;
     };
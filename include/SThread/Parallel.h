@@ -0,0 +1,315 @@
+/******************************************************************/
+/*!
+	@file	Parallel.h
+	@brief	Data-parallel algorithms on a QueueThread or pool
+	@note	A range is cut into chunks of at least grain elements,
+			about CHUNK_PER_THREAD per thread when grain is 0.
+			Helpers posted to the executor and the calling thread
+			claim chunks from one atomic index, so a busy executor
+			only means the caller does more of the work; it never
+			waits for a helper to be scheduled. The call returns
+			when every chunk is done, an exception thrown by a chunk
+			is rethrown on the caller after that.
+	@todo
+	@bug
+
+	@author	Naoto Nakamura
+	@date	Oct. 18, 2026
+*/
+/******************************************************************/
+
+#ifndef STHREAD_PARALLEL_H
+#define STHREAD_PARALLEL_H
+
+#include "SThread/Common.h"
+
+#include <atomic>
+#include <exception>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+#include "SThread/QueueThread.h"
+#include "SThread/WorkerThreadPool.h"
+#include "SThread/WorkStealingPool.h"
+
+
+namespace SThread{
+    //////////////////////////////////////////////////
+    //				forward declarations			//
+    //////////////////////////////////////////////////
+    //implemented
+    class ParallelState;
+    struct ParallelRange;
+
+    //////////////////////////////////////////////////
+    //				class declarations				//
+    //////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @class	ParallelState
+        @brief	Chunk counters shared by the caller and helpers
+        @note	Reference counted, a helper scheduled after the
+                call returned finds no chunk left and only
+                drops its reference. The chunk function lives on
+                the caller's stack and is only called for a
+                claimed chunk, i.e. before the call returns.
+    */
+    /****************************************/
+    class ParallelState
+    {
+    public:
+        static ParallelState *create(const unsigned int numChunk, void (*run)(void *context, size_t chunk), void *context);
+
+        void addRef(){mNumRef.fetch_add(1, std::memory_order_relaxed);}
+        void release();
+
+        //! Run chunks until none is left
+        void work();
+
+        //! Wait until every chunk is done, then rethrow an exception of a chunk
+        void wait();
+
+    private:
+        ParallelState(const unsigned int numChunk, void (*run)(void *context, size_t chunk), void *context);
+        ~ParallelState(){}
+
+    private:
+        std::atomic<unsigned int> mNextChunk;
+        std::atomic<unsigned int> mNumDoneChunk;
+        std::atomic<int> mNumRef;
+        std::atomic<bool> mHasException;
+        std::exception_ptr mException;
+
+        unsigned int mNumChunk;
+        void (*mRun)(void *context, size_t chunk);
+        void *mContext;
+    };
+
+    /****************************************/
+    /*!
+        @struct	ParallelRange
+        @brief	Chunking of [0, num)
+    */
+    /****************************************/
+    struct ParallelRange
+    {
+        static const size_t CHUNK_PER_THREAD = 8;
+
+        size_t num;
+        size_t chunkSize;
+        size_t numChunk;
+
+        ParallelRange(const size_t numElement, const size_t grain, const int numThread)
+        :num(numElement)
+        {
+            size_t target = (size_t)(numThread > 0 ? numThread : 1) * CHUNK_PER_THREAD;
+            chunkSize = (num + target - 1) / target;
+            if(chunkSize < grain) chunkSize = grain;
+            if(chunkSize < 1) chunkSize = 1;
+            numChunk = num > 0 ? (num + chunkSize - 1) / chunkSize : 0;
+        }
+
+        size_t getBegin(const size_t chunk)const{return chunk * chunkSize;}
+        size_t getEnd(const size_t chunk)const{return std::min(num, (chunk + 1) * chunkSize);}
+    };
+
+    //////////////////////////////////////////////////
+    //				function declarations			//
+    //////////////////////////////////////////////////
+    //! Threads which run chunks: the executor's and the caller
+    inline int getParallelism(QueueThread &){return 2;}
+    inline int getParallelism(WorkerThreadPool &pool){return pool.getNumThread() + 1;}
+    inline int getParallelism(WorkStealingPool &pool){return pool.getNumThread() + 1;}
+
+    /****************************************/
+    /*!
+        @brief	Call body(chunk) for chunk in [0, numChunk)
+        @note	Posts up to one helper per executor thread,
+                the caller runs chunks too.
+    */
+    /****************************************/
+    template <class Executor, class Body>
+    void parallelChunks(Executor &executor, const size_t numChunk, Body &body)
+    {
+        if(numChunk == 0) return;
+        if(numChunk == 1){
+            body((size_t)0);
+            return;
+        }
+
+        struct Invoker{
+            static void run(void *context, size_t chunk){(*static_cast<Body*>(context))(chunk);}
+        };
+        ParallelState *state = ParallelState::create((unsigned int)numChunk, &Invoker::run, &body);
+
+        size_t numHelper = std::min((size_t)getParallelism(executor) - 1, numChunk - 1);
+        for(size_t i = 0; i < numHelper; i++){
+            state->addRef();
+            if(!executor.post([state](){
+                state->work();
+                state->release();
+            }, WorkRequest::PRIORITY_HIGH)){
+                state->release();
+            }
+        }
+
+        state->work();
+        try{
+            state->wait();
+        }
+        catch(...){
+            state->release();
+            throw;
+        }
+        state->release();
+    }
+
+    /****************************************/
+    /*!
+        @brief	fn(first, last) over sub-ranges of [begin, end)
+        @note	grain is the minimum sub-range, 0 for automatic.
+    */
+    /****************************************/
+    template <class Executor, class Index, class F>
+    void parallelFor(Executor &executor, const Index begin, const Index end, const Index grain, F &&fn)
+    {
+        if(!(begin < end)) return;
+
+        ParallelRange range((size_t)(end - begin), (size_t)grain, getParallelism(executor));
+        auto body = [&](size_t chunk){
+            fn((Index)(begin + (Index)range.getBegin(chunk)), (Index)(begin + (Index)range.getEnd(chunk)));
+        };
+        parallelChunks(executor, range.numChunk, body);
+    }
+
+    /****************************************/
+    /*!
+        @brief	Reduce [begin, end)
+        @note	fn(first, last) returns the value of a sub-range,
+                the values are combined in range order, so
+                combine needs to be associative only.
+    */
+    /****************************************/
+    template <class Executor, class Index, class T, class F, class Combine>
+    T parallelReduce(Executor &executor, const Index begin, const Index end, const Index grain, const T &identity, F &&fn, Combine &&combine)
+    {
+        if(!(begin < end)) return identity;
+
+        //padded, chunks write their slots concurrently (a vector<bool> would share words)
+        ParallelRange range((size_t)(end - begin), (size_t)grain, getParallelism(executor));
+        std::vector<CachePadded<T> > partials(range.numChunk, CachePadded<T>(identity));
+        auto body = [&](size_t chunk){
+            partials[chunk].value = fn((Index)(begin + (Index)range.getBegin(chunk)), (Index)(begin + (Index)range.getEnd(chunk)));
+        };
+        parallelChunks(executor, range.numChunk, body);
+
+        T ret = identity;
+        for(size_t i = 0; i < partials.size(); i++) ret = combine(ret, partials[i].value);
+        return ret;
+    }
+
+    //! out[i] = op(first[i]) for random access iterators
+    template <class Executor, class InputIt, class OutputIt, class UnaryOp>
+    OutputIt parallelTransform(Executor &executor, InputIt first, InputIt last, OutputIt out, UnaryOp &&op, const size_t grain = 0)
+    {
+        size_t num = (size_t)std::distance(first, last);
+        parallelFor(executor, (size_t)0, num, grain, [&](size_t begin, size_t end){
+            std::transform(first + begin, first + end, out + begin, op);
+        });
+        return out + num;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Sort [first, last)
+        @note	Chunks are sorted in parallel, then merged
+                pairwise in parallel rounds. Stable, std::sort
+                is avoided as its heap fallback trips
+                -Wstrict-overflow.
+    */
+    /****************************************/
+    template <class Executor, class RandomIt, class Compare>
+    void parallelSort(Executor &executor, RandomIt first, RandomIt last, Compare comp, const size_t grain = 0)
+    {
+        size_t num = (size_t)std::distance(first, last);
+        ParallelRange range(num, grain, getParallelism(executor));
+        if(range.numChunk <= 1){
+            std::stable_sort(first, last, comp);
+            return;
+        }
+
+        auto sortBody = [&](size_t chunk){
+            std::stable_sort(first + range.getBegin(chunk), first + range.getEnd(chunk), comp);
+        };
+        parallelChunks(executor, range.numChunk, sortBody);
+
+        //merge runs of width chunks, the last run may be short
+        for(size_t width = 1; width < range.numChunk; width *= 2){
+            size_t numMerge = (range.numChunk + 2 * width - 1) / (2 * width);
+            auto mergeBody = [&](size_t index){
+                size_t begin = range.getBegin(index * 2 * width);
+                size_t middle = std::min(num, range.getBegin(index * 2 * width + width));
+                size_t end = std::min(num, range.getBegin(index * 2 * width + 2 * width));
+                if(middle < end) std::inplace_merge(first + begin, first + middle, first + end, comp);
+            };
+            parallelChunks(executor, numMerge, mergeBody);
+        }
+    }
+
+    template <class Executor, class RandomIt>
+    void parallelSort(Executor &executor, RandomIt first, RandomIt last)
+    {
+        parallelSort(executor, first, last, std::less<typename std::iterator_traits<RandomIt>::value_type>());
+    }
+
+    /****************************************/
+    /*!
+        @brief	Inclusive scan, out[i] = init op first[0] op ... op first[i]
+        @note	Two passes: chunk totals, then each chunk is
+                scanned from the prefix of the chunks before it.
+                op needs to be associative. out may be first.
+    */
+    /****************************************/
+    template <class Executor, class InputIt, class OutputIt, class T, class BinaryOp>
+    OutputIt parallelScan(Executor &executor, InputIt first, InputIt last, OutputIt out, const T &init, BinaryOp &&op, const size_t grain = 0)
+    {
+        size_t num = (size_t)std::distance(first, last);
+        ParallelRange range(num, grain, getParallelism(executor));
+        if(range.numChunk == 0) return out;
+
+        std::vector<CachePadded<T> > totals(range.numChunk);
+        auto totalBody = [&](size_t chunk){
+            size_t begin = range.getBegin(chunk);
+            size_t end = range.getEnd(chunk);
+            T total = first[begin];
+            for(size_t i = begin + 1; i < end; i++) total = op(total, first[i]);
+            totals[chunk].value = total;
+        };
+        parallelChunks(executor, range.numChunk, totalBody);
+
+        //prefix of the chunk totals, totals[c] becomes the value before chunk c
+        T prefix = init;
+        for(size_t c = 0; c < range.numChunk; c++){
+            T total = totals[c].value;
+            totals[c].value = prefix;
+            prefix = op(prefix, total);
+        }
+
+        auto scanBody = [&](size_t chunk){
+            T value = totals[chunk].value;
+            for(size_t i = range.getBegin(chunk); i < range.getEnd(chunk); i++){
+                value = op(value, first[i]);
+                out[i] = value;
+            }
+        };
+        parallelChunks(executor, range.numChunk, scanBody);
+        return out + num;
+    }
+
+}; //namespace SThread
+
+
+#endif //STHREAD_PARALLEL_H
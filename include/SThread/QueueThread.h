@@ -18,11 +18,18 @@
 
 #include "SThread/Common.h"
 
-#include <set>
-#include <deque>
 #include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
 
 #include "SThread/Thread.h"
+#include "SThread/ObjectPool.h"
+#include "SThread/InlineFunction.h"
+#include "SThread/Future.h"
+#include "SThread/Statistics.h"
+#include "SThread/Trace.h"
 
 
 namespace SThread{
@@ -31,9 +38,14 @@ namespace SThread{
     //////////////////////////////////////////////////
     //implemented
     class WorkRequest;
+    class FunctionRequest;
+    class RequestList;
+    class RequestTree;
 
     class QueueThread;
     class WorkerThread;
+    class WorkerThreadPool;
+    class WorkStealingPool;
 
     //////////////////////////////////////////////////
     //				class declarations				//
@@ -51,6 +63,10 @@ namespace SThread{
     {
         friend class QueueThread;
         friend class WorkerThread;
+        friend class WorkerThreadPool;
+        friend class WorkStealingPool;
+        friend class RequestList;
+        friend class RequestTree;
     public:
         //! priority for worker thread class
         enum WorkPriority{
@@ -78,14 +94,63 @@ namespace SThread{
         mAutoDeletedObject(isAutoDeleteObject),
         mIsReseted(TRUE),
         mIsChecked(FALSE),
-        mCondition(NULL)
+        mHookRed(FALSE),
+        mCondition(NULL),
+        mEnqueueTime(0),
+        mTraceId(0),
+        mRecycler(NULL),
+        mHookNext(NULL),
+        mHookPrev(NULL),
+        mHookParent(NULL),
+        mHookOwner(NULL)
         {
         }
         virtual ~WorkRequest(){};
 
+        /****************************************/
+        /*!
+            @brief	Construct a T in ObjectPool<T> storage
+            @note	Auto-deleted requests made here go back to the
+                    pool when they are done. Others are released
+                    with destroy() (delete also works, but skips
+                    the pool).
+        */
+        /****************************************/
+        template <class T, class... Args>
+        static T *create(Args&&... args)
+        {
+            void *memory = ObjectPool<T>::allocate();
+            T *req;
+            try{
+                req = new(memory) T(std::forward<Args>(args)...);
+            }
+            catch(...){
+                ObjectPool<T>::deallocate(memory);
+                throw;
+            }
+            req->mRecycler = &recycle<T>;
+            return req;
+        }
+
+        //! Release a request made by create() or new
+        static void destroy(WorkRequest *req)
+        {
+            if(req == NULL) return;
+            if(req->mRecycler != NULL) req->mRecycler(req);
+            else delete req;
+        }
+
     private:
         virtual bool work() = 0;
 
+        template <class T>
+        static void recycle(WorkRequest *req)
+        {
+            T *object = static_cast<T*>(req);
+            object->~T();
+            ObjectPool<T>::deallocate(object);
+        }
+
     protected:
         void setState(WorkState state){
             WorkState oldState;
@@ -150,8 +215,473 @@ namespace SThread{
         bool mIsReseted;
 
         bool mIsChecked;
+        bool mHookRed;				//!< Node color in a RequestTree, part of the hook below
         
         Condition *mCondition;
+
+        unsigned long long mEnqueueTime;	//!< Timer::now() when queued, 0 without statistics
+        unsigned long long mTraceId;		//!< Links TRACE_ENQUEUE to TRACE_WORK_BEGIN, 0 without tracing
+
+    private:
+        void (*mRecycler)(WorkRequest *req);	//!< Set by create(), NULL for requests made by new
+
+        //intrusive hook, a request is linked in one RequestList or RequestTree at a time
+        WorkRequest *mHookNext;		//!< Next in the list, right child in the tree
+        WorkRequest *mHookPrev;		//!< Previous in the list, left child in the tree
+        WorkRequest *mHookParent;	//!< Parent in the tree
+        const void *mHookOwner;		//!< List or tree which links the request, NULL if none
+    };
+
+    /****************************************/
+    /*!
+     @class    FunctionRequest
+     @brief    Request which runs a callable
+     @note     Callables up to INLINE_SIZE bytes are stored in the
+               request itself, larger ones are moved to the heap.
+               Made by QueueThread::post and the pools' post from
+               ObjectPool<FunctionRequest>, so a small closure costs
+               no allocation once the pool is warm.
+               The callable returns void, or bool for the
+               completed/incompleted state.
+     */
+    /****************************************/
+    class FunctionRequest : public WorkRequest
+    {
+    public:
+        static const size_t INLINE_SIZE = InlineFunction::INLINE_SIZE;
+
+    public:
+        template <class F>
+        explicit FunctionRequest(F &&fn, int priority = PRIORITY_NORMAL, bool isAutoDeleteObject = TRUE)
+        :WorkRequest(priority, isAutoDeleteObject),
+        mFunction(std::forward<F>(fn))
+        {
+        }
+
+        virtual ~FunctionRequest(){}
+
+    private:
+        FunctionRequest(const FunctionRequest&);
+        FunctionRequest &operator=(const FunctionRequest&);
+
+        virtual bool work(){
+            return mFunction();
+        }
+
+    private:
+        InlineFunction mFunction;
+    };
+
+    /****************************************/
+    /*!
+     @class    RequestList
+     @brief    Intrusive FIFO of WorkRequest
+     @note     Links requests through their hook, so push, pop
+               and remove never allocate and remove is O(1).
+               Not synchronized.
+     */
+    /****************************************/
+    class RequestList
+    {
+    public:
+        RequestList()
+        :mHead(NULL),
+        mTail(NULL),
+        mNum(0)
+        {}
+
+        ~RequestList(){clear();}
+
+    private:
+        RequestList(const RequestList&);
+        RequestList &operator=(const RequestList&);
+
+    public:
+        bool isEmpty()const{return mHead == NULL;}
+        int getNum()const{return mNum;}
+        WorkRequest *front(){return mHead;}
+
+        //! return true if req is linked in this list
+        bool contains(const WorkRequest *req)const{return req->mHookOwner == this;}
+
+        void pushBack(WorkRequest *req)
+        {
+            req->mHookOwner = this;
+            req->mHookNext = NULL;
+            req->mHookPrev = mTail;
+            if(mTail != NULL) mTail->mHookNext = req;
+            else mHead = req;
+            mTail = req;
+            mNum++;
+        }
+
+        WorkRequest *popFront()
+        {
+            WorkRequest *ret = mHead;
+            if(ret == NULL) return NULL;
+
+            remove(ret);
+            //the next pop reads the new head's hook
+            if(mHead != NULL) CPU_PREFETCH(mHead);
+            return ret;
+        }
+
+        //! req must be linked in this list
+        void remove(WorkRequest *req)
+        {
+            //mHookPrev of the head is not kept, so a pop does not touch the next request
+            WorkRequest *next = req->mHookNext;
+            if(req == mHead){
+                mHead = next;
+                if(next == NULL) mTail = NULL;
+            }
+            else{
+                WorkRequest *prev = req->mHookPrev;
+                prev->mHookNext = next;
+                if(next != NULL) next->mHookPrev = prev;
+                else mTail = prev;
+            }
+
+            req->mHookNext = NULL;
+            req->mHookPrev = NULL;
+            req->mHookOwner = NULL;
+            mNum--;
+        }
+
+        //! Unlink all requests, they are not deleted
+        void clear()
+        {
+            WorkRequest *req = mHead;
+            while(req != NULL){
+                WorkRequest *next = req->mHookNext;
+                req->mHookNext = NULL;
+                req->mHookPrev = NULL;
+                req->mHookOwner = NULL;
+                req = next;
+            }
+            mHead = NULL;
+            mTail = NULL;
+            mNum = 0;
+        }
+
+    private:
+        WorkRequest *mHead;
+        WorkRequest *mTail;
+        int mNum;
+    };
+
+    /****************************************/
+    /*!
+     @class    RequestTree
+     @brief    Intrusive priority queue of WorkRequest
+     @note     Red-black tree ordered by WorkRequest::higherPriority,
+               the highest request is cached. insert and remove
+               are O(log n), popFirst touches only the neighbors
+               of the first request. None of them allocate.
+               The priority of a linked request must not change.
+               Not synchronized.
+     */
+    /****************************************/
+    class RequestTree
+    {
+    public:
+        RequestTree()
+        :mRoot(NULL),
+        mFirst(NULL),
+        mNum(0)
+        {}
+
+        ~RequestTree(){clear();}
+
+    private:
+        RequestTree(const RequestTree&);
+        RequestTree &operator=(const RequestTree&);
+
+    public:
+        bool isEmpty()const{return mRoot == NULL;}
+        int getNum()const{return mNum;}
+        WorkRequest *first(){return mFirst;}
+
+        //! return true if req is linked in this tree
+        bool contains(const WorkRequest *req)const{return req->mHookOwner == this;}
+
+        void insert(WorkRequest *req)
+        {
+            WorkRequest *parent = NULL;
+            WorkRequest **link = &mRoot;
+            bool isFirst = TRUE;
+            while(*link != NULL){
+                parent = *link;
+                if(req->higherPriority(*parent)){
+                    link = &parent->mHookPrev;
+                }
+                else{
+                    link = &parent->mHookNext;
+                    isFirst = FALSE;
+                }
+            }
+
+            req->mHookOwner = this;
+            req->mHookParent = parent;
+            req->mHookPrev = NULL;
+            req->mHookNext = NULL;
+            req->mHookRed = TRUE;
+            *link = req;
+            if(isFirst) mFirst = req;
+
+            insertFixup(req);
+            mNum++;
+        }
+
+        WorkRequest *popFirst()
+        {
+            WorkRequest *ret = mFirst;
+            if(ret != NULL) remove(ret);
+            return ret;
+        }
+
+        //! req must be linked in this tree
+        void remove(WorkRequest *req)
+        {
+            if(req == mFirst) mFirst = getNext(req);
+            eraseNode(req);
+
+            req->mHookNext = NULL;
+            req->mHookPrev = NULL;
+            req->mHookParent = NULL;
+            req->mHookOwner = NULL;
+            mNum--;
+        }
+
+        //! Unlink all requests, they are not deleted
+        void clear()
+        {
+            WorkRequest *node = mRoot;
+            while(node != NULL){
+                if(node->mHookPrev != NULL){
+                    node = node->mHookPrev;
+                }
+                else if(node->mHookNext != NULL){
+                    node = node->mHookNext;
+                }
+                else{
+                    WorkRequest *parent = node->mHookParent;
+                    if(parent != NULL){
+                        if(parent->mHookPrev == node) parent->mHookPrev = NULL;
+                        else parent->mHookNext = NULL;
+                    }
+                    node->mHookParent = NULL;
+                    node->mHookOwner = NULL;
+                    node = parent;
+                }
+            }
+            mRoot = NULL;
+            mFirst = NULL;
+            mNum = 0;
+        }
+
+    private:
+        static bool isRed(const WorkRequest *node){return node != NULL && node->mHookRed;}
+
+        static WorkRequest *getNext(WorkRequest *node)
+        {
+            if(node->mHookNext != NULL){
+                node = node->mHookNext;
+                while(node->mHookPrev != NULL) node = node->mHookPrev;
+                return node;
+            }
+            WorkRequest *parent = node->mHookParent;
+            while(parent != NULL && node == parent->mHookNext){
+                node = parent;
+                parent = parent->mHookParent;
+            }
+            return parent;
+        }
+
+        void replaceChild(WorkRequest *parent, WorkRequest *oldChild, WorkRequest *newChild)
+        {
+            if(parent == NULL) mRoot = newChild;
+            else if(parent->mHookPrev == oldChild) parent->mHookPrev = newChild;
+            else parent->mHookNext = newChild;
+        }
+
+        void rotateLeft(WorkRequest *node)
+        {
+            WorkRequest *right = node->mHookNext;
+            node->mHookNext = right->mHookPrev;
+            if(right->mHookPrev != NULL) right->mHookPrev->mHookParent = node;
+            right->mHookParent = node->mHookParent;
+            replaceChild(node->mHookParent, node, right);
+            right->mHookPrev = node;
+            node->mHookParent = right;
+        }
+
+        void rotateRight(WorkRequest *node)
+        {
+            WorkRequest *left = node->mHookPrev;
+            node->mHookPrev = left->mHookNext;
+            if(left->mHookNext != NULL) left->mHookNext->mHookParent = node;
+            left->mHookParent = node->mHookParent;
+            replaceChild(node->mHookParent, node, left);
+            left->mHookNext = node;
+            node->mHookParent = left;
+        }
+
+        void insertFixup(WorkRequest *node)
+        {
+            while(isRed(node->mHookParent)){
+                WorkRequest *parent = node->mHookParent;
+                WorkRequest *grand = parent->mHookParent;
+                if(parent == grand->mHookPrev){
+                    WorkRequest *uncle = grand->mHookNext;
+                    if(isRed(uncle)){
+                        parent->mHookRed = FALSE;
+                        uncle->mHookRed = FALSE;
+                        grand->mHookRed = TRUE;
+                        node = grand;
+                        continue;
+                    }
+                    if(node == parent->mHookNext){
+                        rotateLeft(parent);
+                        parent = node;
+                    }
+                    parent->mHookRed = FALSE;
+                    grand->mHookRed = TRUE;
+                    rotateRight(grand);
+                    break;
+                }
+                else{
+                    WorkRequest *uncle = grand->mHookPrev;
+                    if(isRed(uncle)){
+                        parent->mHookRed = FALSE;
+                        uncle->mHookRed = FALSE;
+                        grand->mHookRed = TRUE;
+                        node = grand;
+                        continue;
+                    }
+                    if(node == parent->mHookPrev){
+                        rotateRight(parent);
+                        parent = node;
+                    }
+                    parent->mHookRed = FALSE;
+                    grand->mHookRed = TRUE;
+                    rotateLeft(grand);
+                    break;
+                }
+            }
+            mRoot->mHookRed = FALSE;
+        }
+
+        //! Put child (may be NULL) in the place of node
+        void transplant(WorkRequest *node, WorkRequest *child)
+        {
+            replaceChild(node->mHookParent, node, child);
+            if(child != NULL) child->mHookParent = node->mHookParent;
+        }
+
+        void eraseNode(WorkRequest *node)
+        {
+            WorkRequest *child;
+            WorkRequest *parent;
+            bool isRemovedRed = node->mHookRed;
+
+            if(node->mHookPrev == NULL){
+                child = node->mHookNext;
+                parent = node->mHookParent;
+                transplant(node, child);
+            }
+            else if(node->mHookNext == NULL){
+                child = node->mHookPrev;
+                parent = node->mHookParent;
+                transplant(node, child);
+            }
+            else{
+                //the successor takes the place and the color of node
+                WorkRequest *next = node->mHookNext;
+                while(next->mHookPrev != NULL) next = next->mHookPrev;
+                isRemovedRed = next->mHookRed;
+                child = next->mHookNext;
+
+                if(next->mHookParent == node){
+                    parent = next;
+                }
+                else{
+                    parent = next->mHookParent;
+                    transplant(next, child);
+                    next->mHookNext = node->mHookNext;
+                    next->mHookNext->mHookParent = next;
+                }
+                transplant(node, next);
+                next->mHookPrev = node->mHookPrev;
+                next->mHookPrev->mHookParent = next;
+                next->mHookRed = node->mHookRed;
+            }
+
+            if(!isRemovedRed) eraseFixup(child, parent);
+        }
+
+        void eraseFixup(WorkRequest *node, WorkRequest *parent)
+        {
+            while(node != mRoot && !isRed(node)){
+                if(node == parent->mHookPrev){
+                    WorkRequest *sibling = parent->mHookNext;
+                    if(isRed(sibling)){
+                        sibling->mHookRed = FALSE;
+                        parent->mHookRed = TRUE;
+                        rotateLeft(parent);
+                        sibling = parent->mHookNext;
+                    }
+                    if(!isRed(sibling->mHookPrev) && !isRed(sibling->mHookNext)){
+                        sibling->mHookRed = TRUE;
+                        node = parent;
+                        parent = node->mHookParent;
+                        continue;
+                    }
+                    if(!isRed(sibling->mHookNext)){
+                        sibling->mHookPrev->mHookRed = FALSE;
+                        sibling->mHookRed = TRUE;
+                        rotateRight(sibling);
+                        sibling = parent->mHookNext;
+                    }
+                    sibling->mHookRed = parent->mHookRed;
+                    parent->mHookRed = FALSE;
+                    sibling->mHookNext->mHookRed = FALSE;
+                    rotateLeft(parent);
+                }
+                else{
+                    WorkRequest *sibling = parent->mHookPrev;
+                    if(isRed(sibling)){
+                        sibling->mHookRed = FALSE;
+                        parent->mHookRed = TRUE;
+                        rotateRight(parent);
+                        sibling = parent->mHookPrev;
+                    }
+                    if(!isRed(sibling->mHookPrev) && !isRed(sibling->mHookNext)){
+                        sibling->mHookRed = TRUE;
+                        node = parent;
+                        parent = node->mHookParent;
+                        continue;
+                    }
+                    if(!isRed(sibling->mHookPrev)){
+                        sibling->mHookNext->mHookRed = FALSE;
+                        sibling->mHookRed = TRUE;
+                        rotateLeft(sibling);
+                        sibling = parent->mHookPrev;
+                    }
+                    sibling->mHookRed = parent->mHookRed;
+                    parent->mHookRed = FALSE;
+                    sibling->mHookPrev->mHookRed = FALSE;
+                    rotateRight(parent);
+                }
+                node = mRoot;
+            }
+            if(node != NULL) node->mHookRed = FALSE;
+        }
+
+    private:
+        WorkRequest *mRoot;
+        WorkRequest *mFirst;		//!< Highest priority request
+        int mNum;
     };
     
     /****************************************/
@@ -173,8 +703,30 @@ namespace SThread{
         
     public:
         virtual bool add(WorkRequest *req) = 0;
+        //! req must be alive, intrusive containers read its link
         virtual bool erase(WorkRequest *req) = 0;
 
+        //! Pop up to max requests in order, return the number popped
+        virtual int popBatch(WorkRequest **reqs, const int max)
+        {
+            int i = 0;
+            for(; i < max; i++){
+                reqs[i] = pop();
+                if(reqs[i] == NULL) break;
+            }
+            return i;
+        }
+
+        //! Add num requests in order, return the number actually added
+        virtual int addBatch(WorkRequest **reqs, const int num)
+        {
+            int i = 0;
+            for(; i < num; i++){
+                if(!add(reqs[i])) break;
+            }
+            return i;
+        }
+
         virtual void init() = 0;
         virtual void cleanup() = 0;
 
@@ -182,14 +734,23 @@ namespace SThread{
 
         virtual int getNum() = 0;
         virtual WorkRequest* pop() = 0;
+
+        //! Lock-free and possibly stale, for polling by an idle consumer
+        virtual bool hasRequest(){return getNum() > 0;}
+
+        //! return true if add/pop are safe without the owner's condition lock
+        virtual bool isLockFree(){return FALSE;}
     };
     
     class QueueRequestContainer : public RequestContainer
     {
     public:
         QueueRequestContainer()
-        :RequestContainer()
-        {}
+        :RequestContainer(),
+        mNumHint(0)
+        {
+            mLocker.setProfileName("QueueRequestContainer::mLocker");
+        }
         
         virtual ~QueueRequestContainer(){}
         
@@ -197,35 +758,41 @@ namespace SThread{
         virtual bool add(WorkRequest *req)
         {
             mLocker.lock();
-            mRequestQueue.push_back(req);
+            mRequestQueue.pushBack(req);
+            updateHint();
             mLocker.unlock();
             return TRUE;
         }
+
+        virtual int addBatch(WorkRequest **reqs, const int num)
+        {
+            mLocker.lock();
+            for(int i = 0; i < num; i++) mRequestQueue.pushBack(reqs[i]);
+            updateHint();
+            mLocker.unlock();
+            return num;
+        }
         
         virtual bool erase(WorkRequest *req)
         {
             mLocker.lock();
-            std::deque<WorkRequest*>::iterator ite = mRequestQueue.begin();
-            while(mRequestQueue.end() != ite){
-                if(*ite == req){
-                    mRequestQueue.erase(ite);
-                    mLocker.unlock();
-                    return TRUE;
-                }
-                ite++;
-            }
+            bool ret = mRequestQueue.contains(req);
+            if(ret) mRequestQueue.remove(req);
+            updateHint();
             mLocker.unlock();
-            return FALSE;
+            return ret;
         }
         
         virtual int getNum()
         {
             mLocker.lock();
-            int ret = (int)mRequestQueue.size();
+            int ret = mRequestQueue.getNum();
             mLocker.unlock();
             return ret;
         }
 
+        virtual bool hasRequest(){return mNumHint.load(std::memory_order_relaxed) > 0;}
+
         virtual void init(){}
         virtual void cleanup(){}
 
@@ -233,80 +800,450 @@ namespace SThread{
         {
             mLocker.lock();
             mRequestQueue.clear();
+            updateHint();
             mLocker.unlock();
         }
         
         virtual WorkRequest* pop()
         {
             mLocker.lock();
-            if(mRequestQueue.size() == 0){
-                mLocker.unlock();
-                return NULL;
-            }
-            WorkRequest *ret = mRequestQueue.front();
-            mRequestQueue.pop_front();
+            WorkRequest *ret = mRequestQueue.popFront();
+            updateHint();
             mLocker.unlock();
             return ret;
         }
+
+        virtual int popBatch(WorkRequest **reqs, const int max)
+        {
+            mLocker.lock();
+            int num = 0;
+            while(num < max && !mRequestQueue.isEmpty()){
+                reqs[num++] = mRequestQueue.popFront();
+            }
+            updateHint();
+            mLocker.unlock();
+            return num;
+        }
         
     private:
-        std::deque<WorkRequest*> mRequestQueue;
+        void updateHint(){mNumHint.store(mRequestQueue.getNum(), std::memory_order_relaxed);}
+
+    private:
+        RequestList mRequestQueue;
         
         SpinLock mLocker;
+        std::atomic<int> mNumHint;		//!< getNum() written under mLocker, read without it
     };
     
     class WorkerRequestContainer : public RequestContainer
     {
     public:
         WorkerRequestContainer()
-        :RequestContainer()
-        {}
+        :RequestContainer(),
+        mNumHint(0)
+        {
+            mLocker.setProfileName("WorkerRequestContainer::mLocker");
+        }
         
         virtual ~WorkerRequestContainer(){}
         
-        struct RequestLess
-        {
-            bool operator()(const WorkRequest* lhs, const WorkRequest* rhs) const
-            {
-                return lhs->higherPriority(*rhs);
-            }
-        };
-
-        
     public:
         virtual bool add(WorkRequest *req)
         {
-            mRequestSet.insert(req);
+            mLocker.lock();
+            mRequestTree.insert(req);
+            updateHint();
+            mLocker.unlock();
             return TRUE;
         }
+
+        virtual int addBatch(WorkRequest **reqs, const int num)
+        {
+            mLocker.lock();
+            for(int i = 0; i < num; i++) mRequestTree.insert(reqs[i]);
+            updateHint();
+            mLocker.unlock();
+            return num;
+        }
         
         virtual bool erase(WorkRequest *req)
         {
-            mRequestSet.erase(req);
-            return FALSE;
+            mLocker.lock();
+            bool ret = mRequestTree.contains(req);
+            if(ret) mRequestTree.remove(req);
+            updateHint();
+            mLocker.unlock();
+            return ret;
         }
         
         virtual int getNum()
         {
-            return (int)mRequestSet.size();
+            mLocker.lock();
+            int ret = mRequestTree.getNum();
+            mLocker.unlock();
+            return ret;
         }
-        
+
+        virtual bool hasRequest(){return mNumHint.load(std::memory_order_relaxed) > 0;}
+
+        virtual void init(){}
+        virtual void cleanup(){}
+
         virtual void clear()
         {
-            mRequestSet.clear();
+            mLocker.lock();
+            mRequestTree.clear();
+            updateHint();
+            mLocker.unlock();
         }
         
         virtual WorkRequest* pop()
         {
-            if(mRequestSet.size() == 0) return NULL;
-            WorkRequest *ret  = *mRequestSet.begin();
-            mRequestSet.erase(ret);
+            mLocker.lock();
+            WorkRequest *ret = mRequestTree.popFirst();
+            updateHint();
+            mLocker.unlock();
             return ret;
         }
+
+        virtual int popBatch(WorkRequest **reqs, const int max)
+        {
+            mLocker.lock();
+            int num = 0;
+            while(num < max && !mRequestTree.isEmpty()){
+                reqs[num++] = mRequestTree.popFirst();
+            }
+            updateHint();
+            mLocker.unlock();
+            return num;
+        }
         
     private:
-        std::multiset<WorkRequest*, RequestLess> mRequestSet;
+        void updateHint(){mNumHint.store(mRequestTree.getNum(), std::memory_order_relaxed);}
 
+    private:
+        RequestTree mRequestTree;
+
+        SpinLock mLocker;
+        std::atomic<int> mNumHint;		//!< getNum() written under mLocker, read without it
+    };
+
+    /****************************************/
+    /*!
+     @class    PriorityBucketRequestContainer
+     @brief    Priority container with one FIFO per priority band
+     @note     The band is the PRIORITY_HIGHBITS part of the priority,
+               so PRIORITY_LOWEST ... PRIORITY_IMMEDIATE each get
+               their own band. Order inside a band is FIFO and the
+               lower bits of the priority are ignored.
+     */
+    /****************************************/
+    class PriorityBucketRequestContainer : public RequestContainer
+    {
+    public:
+        static const int NUM_BAND = 8;
+
+    public:
+        PriorityBucketRequestContainer()
+        :RequestContainer(),
+        mBandBits(0),
+        mNum(0),
+        mNumHint(0)
+        {
+            mLocker.setProfileName("PriorityBucketRequestContainer::mLocker");
+        }
+
+        virtual ~PriorityBucketRequestContainer(){}
+
+        static int getBand(int priority)
+        {
+            if(priority < 0) return 0;
+            return (priority & WorkRequest::PRIORITY_HIGHBITS) >> 28;
+        }
+
+    public:
+        virtual bool add(WorkRequest *req)
+        {
+            int band = getBand(req->getPriority());
+            mLocker.lock();
+            mBuckets[band].pushBack(req);
+            mBandBits |= 1u << band;
+            mNum++;
+            mNumHint.store(mNum, std::memory_order_relaxed);
+            mLocker.unlock();
+            return TRUE;
+        }
+
+        virtual int addBatch(WorkRequest **reqs, const int num)
+        {
+            mLocker.lock();
+            for(int i = 0; i < num; i++){
+                int band = getBand(reqs[i]->getPriority());
+                mBuckets[band].pushBack(reqs[i]);
+                mBandBits |= 1u << band;
+            }
+            mNum += num;
+            mNumHint.store(mNum, std::memory_order_relaxed);
+            mLocker.unlock();
+            return num;
+        }
+
+        virtual bool erase(WorkRequest *req)
+        {
+            mLocker.lock();
+            for(int band = 0; band < NUM_BAND; band++){
+                RequestList &bucket = mBuckets[band];
+                if(bucket.contains(req)){
+                    bucket.remove(req);
+                    if(bucket.isEmpty()) mBandBits &= ~(1u << band);
+                    mNum--;
+                    mNumHint.store(mNum, std::memory_order_relaxed);
+                    mLocker.unlock();
+                    return TRUE;
+                }
+            }
+            mLocker.unlock();
+            return FALSE;
+        }
+
+        virtual int getNum()
+        {
+            mLocker.lock();
+            int ret = mNum;
+            mLocker.unlock();
+            return ret;
+        }
+
+        virtual bool hasRequest(){return mNumHint.load(std::memory_order_relaxed) > 0;}
+
+        virtual void init(){}
+        virtual void cleanup(){}
+
+        virtual void clear()
+        {
+            mLocker.lock();
+            for(int band = 0; band < NUM_BAND; band++) mBuckets[band].clear();
+            mBandBits = 0;
+            mNum = 0;
+            mNumHint.store(mNum, std::memory_order_relaxed);
+            mLocker.unlock();
+        }
+
+        virtual WorkRequest* pop()
+        {
+            mLocker.lock();
+            if(mBandBits == 0){
+                mLocker.unlock();
+                return NULL;
+            }
+            int band = highestBand(mBandBits);
+            RequestList &bucket = mBuckets[band];
+            WorkRequest *ret = bucket.popFront();
+            if(bucket.isEmpty()) mBandBits &= ~(1u << band);
+            mNum--;
+            mNumHint.store(mNum, std::memory_order_relaxed);
+            mLocker.unlock();
+            return ret;
+        }
+
+        virtual int popBatch(WorkRequest **reqs, const int max)
+        {
+            mLocker.lock();
+            int num = 0;
+            while(num < max && mBandBits != 0){
+                int band = highestBand(mBandBits);
+                RequestList &bucket = mBuckets[band];
+                while(num < max && !bucket.isEmpty()){
+                    reqs[num++] = bucket.popFront();
+                }
+                if(bucket.isEmpty()) mBandBits &= ~(1u << band);
+            }
+            mNum -= num;
+            mNumHint.store(mNum, std::memory_order_relaxed);
+            mLocker.unlock();
+            return num;
+        }
+
+    private:
+        static int highestBand(unsigned int bits)
+        {
+#if defined COMPILER_MSVC
+            unsigned long index;
+            _BitScanReverse(&index, bits);
+            return (int)index;
+#elif defined COMPILER_GCC
+            return 31 - __builtin_clz(bits);
+#endif
+        }
+
+    private:
+        RequestList mBuckets[NUM_BAND];
+        unsigned int mBandBits;		//!< Bit n is set when band n is not empty
+        int mNum;
+
+        SpinLock mLocker;
+        std::atomic<int> mNumHint;		//!< mNum written under mLocker, read without it
+    };
+
+    /****************************************/
+    /*!
+     @class    MPSCRequestContainer
+     @brief    Bounded lock-free FIFO for many producers and one consumer
+     @note     add() returns FALSE when the ring is full.
+               pop() must be called from the owning thread only,
+               or by another thread once the owner is joined.
+     */
+    /****************************************/
+    class MPSCRequestContainer : public RequestContainer
+    {
+    public:
+        explicit MPSCRequestContainer(unsigned long capacity = 4096)
+        :RequestContainer(),
+        mCells(NULL),
+        mMask(0),
+        mEnqueuePos(0),
+        mDequeuePos(0),
+        mNumHole(0)
+        {
+            unsigned long size = 2;
+            while(size < capacity) size <<= 1;
+
+            mCells = new Cell[size];
+            mMask = size - 1;
+            for(unsigned long i = 0; i < size; i++){
+                mCells[i].sequence.store(i, std::memory_order_relaxed);
+                mCells[i].request.store(NULL, std::memory_order_relaxed);
+            }
+        }
+
+        virtual ~MPSCRequestContainer(){
+            SAFE_DELETE_ARRAY(mCells);
+        }
+
+    public:
+        virtual bool add(WorkRequest *req)
+        {
+            Cell *cell;
+            unsigned long pos = mEnqueuePos.load(std::memory_order_relaxed);
+            while(1){
+                cell = &mCells[pos & mMask];
+                unsigned long seq = cell->sequence.load(std::memory_order_acquire);
+                long dif = (long)seq - (long)pos;
+                if(dif == 0){
+                    if(mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                }
+                else if(dif < 0){
+                    return FALSE;
+                }
+                else{
+                    pos = mEnqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+            cell->request.store(req, std::memory_order_relaxed);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return TRUE;
+        }
+
+        //! Claims num consecutive cells with one CAS when they are free
+        virtual int addBatch(WorkRequest **reqs, const int num)
+        {
+            if(num <= 0) return 0;
+            if((unsigned long)num > mMask + 1) return RequestContainer::addBatch(reqs, num);
+
+            unsigned long pos = mEnqueuePos.load(std::memory_order_relaxed);
+            while(1){
+                //cells are released in order, so the last cell being free means all are
+                unsigned long last = pos + num - 1;
+                unsigned long seq = mCells[last & mMask].sequence.load(std::memory_order_acquire);
+                long dif = (long)seq - (long)last;
+                if(dif == 0){
+                    if(mEnqueuePos.compare_exchange_weak(pos, pos + num, std::memory_order_relaxed)) break;
+                }
+                else if(dif < 0){
+                    return RequestContainer::addBatch(reqs, num);
+                }
+                else{
+                    pos = mEnqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+
+            for(int i = 0; i < num; i++){
+                Cell *cell = &mCells[(pos + i) & mMask];
+                cell->request.store(reqs[i], std::memory_order_relaxed);
+                cell->sequence.store(pos + i + 1, std::memory_order_release);
+            }
+            return num;
+        }
+
+        //! Erased slots stay in the ring as holes and are skipped by pop()
+        virtual bool erase(WorkRequest *req)
+        {
+            unsigned long pos = mDequeuePos.load(std::memory_order_acquire);
+            unsigned long end = mEnqueuePos.load(std::memory_order_acquire);
+            for(; pos != end; pos++){
+                Cell *cell = &mCells[pos & mMask];
+                if(cell->sequence.load(std::memory_order_acquire) != pos + 1) continue;
+                WorkRequest *expect = req;
+                if(cell->request.compare_exchange_strong(expect, NULL)){
+                    mNumHole.fetch_add(1, std::memory_order_relaxed);
+                    return TRUE;
+                }
+            }
+            return FALSE;
+        }
+
+        //! Holes left by erase() are not counted
+        virtual int getNum()
+        {
+            unsigned long head = mDequeuePos.load(std::memory_order_acquire);
+            unsigned long tail = mEnqueuePos.load(std::memory_order_acquire);
+            long num = tail > head ? (long)(tail - head) : 0;
+            num -= mNumHole.load(std::memory_order_relaxed);
+            return num > 0 ? (int)num : 0;
+        }
+
+        virtual void init(){}
+        virtual void cleanup(){}
+
+        virtual void clear()
+        {
+            while(pop() != NULL);
+        }
+
+        virtual WorkRequest* pop()
+        {
+            unsigned long pos = mDequeuePos.load(std::memory_order_relaxed);
+            while(1){
+                Cell *cell = &mCells[pos & mMask];
+                if(cell->sequence.load(std::memory_order_acquire) != pos + 1) return NULL;
+
+                WorkRequest *ret = cell->request.exchange(NULL, std::memory_order_acquire);
+                cell->sequence.store(pos + mMask + 1, std::memory_order_release);
+                pos++;
+                mDequeuePos.store(pos, std::memory_order_release);
+
+                if(ret != NULL) return ret;
+                mNumHole.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        virtual bool isLockFree(){return TRUE;}
+
+        unsigned long getCapacity(){return mMask + 1;}
+
+    private:
+        struct Cell
+        {
+            std::atomic<unsigned long> sequence;
+            std::atomic<WorkRequest*> request;
+        };
+
+        Cell *mCells;
+        unsigned long mMask;
+
+        ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) std::atomic<unsigned long> mEnqueuePos;	//!< Written by producers
+        ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) std::atomic<unsigned long> mDequeuePos;	//!< Written by the consumer
+        ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) std::atomic<long> mNumHole;		//!< Erased cells not popped yet
     };
 
 
@@ -321,6 +1258,25 @@ namespace SThread{
     /****************************************/
     class QueueThread : public Thread
     {
+    public:
+        //! What the thread does while its container is empty
+        enum IdlePolicy{
+            IDLE_PARK,				//!< Sleep on the request condition at once
+            IDLE_SPIN_THEN_PARK		//!< Spin with pause, then yield, then sleep
+        };
+
+        //! Which idle phase picked up the next request
+        struct IdleStatistics
+        {
+            unsigned long numSpin;
+            unsigned long numYield;
+            unsigned long numPark;
+            int spinBudget;			//!< Current adaptive spin count
+        };
+
+        static const int DEFAULT_SPIN_COUNT = 2000;
+        static const int DEFAULT_YIELD_COUNT = 50;
+
     public:
         QueueThread(
                     RequestContainer *container = NULL,
@@ -335,13 +1291,43 @@ namespace SThread{
     protected:
         virtual void run();
         virtual WorkRequest::WorkState processNextWork();
+        WorkRequest::WorkState processRequest(WorkRequest *currentRequest);
+        int popRequests(WorkRequest **reqs, const int max);
+        WorkRequest::WorkState processBatch(const int num);
+        virtual WorkRequest::WorkState workBatch(WorkRequest **reqs, const int num);
+
+        void setProcessing(bool isProcessing){
+            mProcessingLocker->lock();
+            mIsProcessing = isProcessing;
+            mProcessingLocker->unlock();
+        }
+
         virtual bool workRequest(WorkRequest *request);
 
+        void waitRequest();
+        bool spinRequest();
+        void wakeupWaiting();
+        bool beginLockFreeAdd();
+
+        //! Idle accounting around a wait, 0 when nothing is measured
+        //! A wait which returns at once counts as a few ns of idle time,
+        //! checking the container first would take its lock every loop.
+        unsigned long long beginIdle(){
+            if(!mIsStatisticsEnabled) return 0;
+            return Timer::now();
+        }
+        void endIdle(unsigned long long beginTime){
+            if(beginTime != 0) LatencyHistogram::increment(mIdleNanoTotal, Timer::now() - beginTime);
+        }
+
+        void recordStatistics(WorkRequest::WorkState state, unsigned long long enqueueTime, unsigned long long startTime, unsigned long long finishTime);
+
     public:
         virtual void init();
         virtual void cleanup();
     
         int getNumWork(){
+            if(mRequestContainer->isLockFree()) return mRequestContainer->getNum();
             mRequestCondition.lock();
             int ret = (int)mRequestContainer->getNum();
             mRequestCondition.unlock();
@@ -356,10 +1342,70 @@ namespace SThread{
         }
 
         virtual bool addRequest(WorkRequest *req, const bool resume = TRUE);
+        virtual int addRequests(WorkRequest **reqs, const int num, const bool resume = TRUE);
         virtual bool eraseRequest(WorkRequest *req);
 
+        /****************************************/
+        /*!
+            @brief	Queue a callable as a pooled FunctionRequest
+            @note	Returns FALSE (the callable is dropped) when
+                    the request could not be added.
+        */
+        /****************************************/
+        template <class F>
+        bool post(F &&fn, const int priority = WorkRequest::PRIORITY_NORMAL, const bool resume = TRUE)
+        {
+            WorkRequest *req = WorkRequest::create<FunctionRequest>(std::forward<F>(fn), priority);
+            if(addRequest(req, resume)) return TRUE;
+            WorkRequest::destroy(req);
+            return FALSE;
+        }
+
+        /****************************************/
+        /*!
+            @brief	post() with a Future of the callable's result
+            @note	An exception thrown by fn is rethrown by
+                    Future::get. A request which could not be added
+                    or was cleared without running completes the
+                    future with std::future_errc::broken_promise.
+        */
+        /****************************************/
+        template <class F>
+        Future<typename std::invoke_result<typename std::decay<F>::type&>::type> submit(F &&fn, const int priority = WorkRequest::PRIORITY_NORMAL, const bool resume = TRUE)
+        {
+            typedef typename std::invoke_result<typename std::decay<F>::type&>::type Result;
+
+            Promise<Result> promise;
+            Future<Result> ret = promise.getFuture();
+            post([promise = std::move(promise), fn = std::forward<F>(fn)]() mutable {promise.fulfill(fn);}, priority, resume);
+            return ret;
+        }
+
+        //! Pop and delete the queued requests, only after the thread is joined (cleanup() does)
         void clearAllRequest();
 
+        void setDrainBatchSize(const int num);
+        int getDrainBatchSize(){return mDrainBatchSize;}
+
+        void setIdlePolicy(IdlePolicy policy, const int maxSpinCount = DEFAULT_SPIN_COUNT, const int yieldCount = DEFAULT_YIELD_COUNT);
+        IdlePolicy getIdlePolicy(){return mIdlePolicy;}
+        IdleStatistics getIdleStatistics();
+
+        //! How long an idle consumer parks before re-checking (set before start())
+        void setIdleTime(const unsigned long milliSec){mIdleNanoTime = (unsigned long long)milliSec * 1000000ULL;}
+
+        template <class Rep, class Period>
+        void setIdleTime(const std::chrono::duration<Rep, Period> &idleTime){mIdleNanoTime = Timer::toNanoTime(idleTime);}
+
+        unsigned long long getIdleNanoTime(){return mIdleNanoTime;}
+
+        //! Record wait/service time and counters (set before start())
+        void setStatisticsEnabled(const bool isEnabled){mIsStatisticsEnabled = isEnabled;}
+        bool isStatisticsEnabled(){return mIsStatisticsEnabled;}
+
+        //! Snapshot taken while the thread keeps running
+        QueueThreadStatistics getStatistics();
+
         virtual bool shutdown();
 
         virtual bool suspend();
@@ -367,20 +1413,49 @@ namespace SThread{
 
         void signalAll(){ mRequestCondition.signalAll(); }
     protected:
-        Condition mRequestCondition;
-
+        //read-mostly, set up before start()
         ResourceLock *mWorkLocker;
         ResourceLock *mProcessingLocker;
 
-        std::atomic<bool> mIsSuspended;
-        Condition mSupendCondition;
-
-        bool mIsProcessing;
-        
         RequestContainer *mRequestContainer;
         bool mIsComtainerAutoDelete;
-        
-        unsigned long mIdleTime;
+
+        unsigned long long mIdleNanoTime;
+
+        IdlePolicy mIdlePolicy;
+        int mMaxSpinCount;
+        int mYieldCount;
+        int mDrainBatchSize;
+
+        bool mIsStatisticsEnabled;
+
+        //written by producers and the consumer
+        ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) Condition mRequestCondition;
+        CachePadded<std::atomic<bool> > mIsWaiting;	//!< Written by the consumer, polled by producers
+        CachePadded<std::atomic<int> > mNumAdding;	//!< Lock-free adds between the state check and the push
+
+        //written by suspend()/resume()
+        ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) std::atomic<bool> mIsSuspended;
+        Condition mSupendCondition;
+
+        //written by the consumer only
+        ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) bool mIsProcessing;
+        WorkRequest **mDrainBatch;	//!< Requests drained by one lock acquisition
+        std::atomic<int> mSpinBudget;	//!< Also read by getIdleStatistics()
+        int mAverageArrival;		//!< Moving average of iterations until a request arrived
+
+        std::atomic<unsigned long> mNumPickedBySpin;
+        std::atomic<unsigned long> mNumPickedByYield;
+        std::atomic<unsigned long> mNumPickedByPark;
+
+        std::atomic<unsigned long long> mNumCompleted;
+        std::atomic<unsigned long long> mNumIncompleted;
+        std::atomic<unsigned long long> mNumAborted;
+        std::atomic<unsigned long long> mBusyTime;
+        std::atomic<unsigned long long> mIdleNanoTotal;	//!< Not mIdleNanoTime, the park timeout
+
+        LatencyHistogram mWaitTime;			//!< Enqueue to start
+        LatencyHistogram mServiceTime;		//!< Start to finish
     };
 
     
@@ -62,6 +62,54 @@ namespace SThread{
 
 #endif
 
+//spin-wait hint
+#if defined COMPILER_MSVC
+#define CPU_PAUSE() YieldProcessor()
+#elif defined SIMDARCH_SSE
+#define CPU_PAUSE() _mm_pause()
+#elif defined ARCHTECTURE_ARM
+#define CPU_PAUSE() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define CPU_PAUSE() __asm__ __volatile__("" ::: "memory")
+#endif
+
+//read prefetch hint
+#if defined COMPILER_MSVC && defined SIMDARCH_SSE
+#define CPU_PREFETCH(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#elif defined COMPILER_GCC
+#define CPU_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define CPU_PREFETCH(p)
+#endif
+
+    /****************************************/
+    /*!
+        @struct CachePadded
+        @brief  Value aligned to and padded out to a cache line
+        @note   Keeps a field written by one thread off the line
+                of fields written by another thread.
+    */
+    /****************************************/
+    template <typename T>
+    struct ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) CachePadded
+    {
+        CachePadded():value(){}
+
+        template <typename U>
+        explicit CachePadded(const U &init):value(init){}
+
+        T *get(){return &value;}
+        const T *get() const {return &value;}
+
+        T *operator->(){return &value;}
+        const T *operator->() const {return &value;}
+
+        T &operator*(){return value;}
+        const T &operator*() const {return value;}
+
+        T value;
+    };
+
     template <typename Ty, std::size_t N = 16>
 
     class AlignedBlockAllocator
@@ -18,7 +18,19 @@
 
 #include "SThread/Timer.h"
 #include "SThread/Lock.h"
+#include "SThread/LockProfiler.h"
 #include "SThread/Thread.h"
+#include "SThread/Statistics.h"
+#include "SThread/Trace.h"
+#include "SThread/ObjectPool.h"
+#include "SThread/InlineFunction.h"
+#include "SThread/Future.h"
 #include "SThread/QueueThread.h"
+#include "SThread/WorkerThreadPool.h"
+#include "SThread/WorkStealingPool.h"
+#include "SThread/TaskGraph.h"
+#include "SThread/Parallel.h"
+#include "SThread/TimerThread.h"
+#include "SThread/Coroutine.h"
 
 #endif // SThread
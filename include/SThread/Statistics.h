@@ -0,0 +1,254 @@
+/******************************************************************/
+/*!
+	@file	Statistics.h
+	@brief	Latency histograms and counters of QueueThread
+	@note	Recording is done by the owning thread only, so the
+			counters are updated with plain relaxed load/store
+			(no locked instruction) and can be read by other
+			threads at any time.
+	@todo
+	@bug
+
+	@author	Naoto Nakamura
+	@date	Oct. 18, 2026
+*/
+/******************************************************************/
+
+#ifndef STHREAD_STATISTICS_H
+#define STHREAD_STATISTICS_H
+
+#include "SThread/Common.h"
+
+#include <atomic>
+#include <string.h>
+
+
+namespace SThread{
+    //////////////////////////////////////////////////
+    //				forward declarations			//
+    //////////////////////////////////////////////////
+    //implemented
+    class HistogramSnapshot;
+    class LatencyHistogram;
+    struct QueueThreadStatistics;
+
+    //////////////////////////////////////////////////
+    //				class declarations				//
+    //////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @class	HistogramSnapshot
+        @brief	Copy of a LatencyHistogram
+        @note	Log-linear buckets as in HdrHistogram: values
+                below 2 * NUM_SUB_BUCKET are exact, larger values
+                share a bucket with at most 1/NUM_SUB_BUCKET
+                relative error. Values are nanoseconds.
+    */
+    /****************************************/
+    class HistogramSnapshot
+    {
+    public:
+        static const int SUB_BUCKET_BITS = 3;
+        static const int NUM_SUB_BUCKET = 1 << SUB_BUCKET_BITS;
+        static const int MAX_VALUE_BITS = 40;		//!< About 18 minutes, larger values are clamped
+        static const int NUM_BUCKET = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * NUM_SUB_BUCKET;
+
+    public:
+        HistogramSnapshot(){clear();}
+
+    public:
+        void clear()
+        {
+            memset(mCounts, 0, sizeof(mCounts));
+            mCount = 0;
+            mSum = 0;
+            mMax = 0;
+        }
+
+        void merge(const HistogramSnapshot &other)
+        {
+            for(int i = 0; i < NUM_BUCKET; i++) mCounts[i] += other.mCounts[i];
+            mCount += other.mCount;
+            mSum += other.mSum;
+            if(other.mMax > mMax) mMax = other.mMax;
+        }
+
+        unsigned long long getCount() const {return mCount;}
+        unsigned long long getMax() const {return mMax;}
+        unsigned long long getSum() const {return mSum;}
+        double getMean() const {return mCount > 0 ? (double)mSum / (double)mCount : 0.0;}
+
+        //! Highest value of the bucket holding the ratio (0.0 - 1.0) quantile
+        unsigned long long getPercentile(double ratio) const
+        {
+            unsigned long long total = 0;
+            for(int i = 0; i < NUM_BUCKET; i++) total += mCounts[i];
+            if(total == 0) return 0;
+
+            unsigned long long rank = (unsigned long long)(ratio * (double)total + 0.5);
+            if(rank < 1) rank = 1;
+            if(rank > total) rank = total;
+
+            unsigned long long seen = 0;
+            for(int i = 0; i < NUM_BUCKET; i++){
+                seen += mCounts[i];
+                if(seen >= rank){
+                    unsigned long long upper = getBucketUpper(i);
+                    return upper < mMax ? upper : mMax;
+                }
+            }
+            return mMax;
+        }
+
+        unsigned long long getBucketCount(const int index) const {return mCounts[index];}
+
+        static int getBucketIndex(unsigned long long value)
+        {
+            if(value < 2 * NUM_SUB_BUCKET) return (int)value;
+            if(value >> MAX_VALUE_BITS) value = (1ULL << MAX_VALUE_BITS) - 1;
+
+            int exponent = highestBit(value);
+            int shift = exponent - SUB_BUCKET_BITS;
+            return (shift + 1) * NUM_SUB_BUCKET + (int)((value >> shift) & (NUM_SUB_BUCKET - 1));
+        }
+
+        static unsigned long long getBucketLower(const int index)
+        {
+            if(index < 2 * NUM_SUB_BUCKET) return (unsigned long long)index;
+
+            int shift = index / NUM_SUB_BUCKET - 1;
+            return (unsigned long long)(NUM_SUB_BUCKET + index % NUM_SUB_BUCKET) << shift;
+        }
+
+        static unsigned long long getBucketUpper(const int index)
+        {
+            if(index < 2 * NUM_SUB_BUCKET) return (unsigned long long)index;
+
+            int shift = index / NUM_SUB_BUCKET - 1;
+            return getBucketLower(index) + (1ULL << shift) - 1;
+        }
+
+    private:
+        static int highestBit(unsigned long long value)
+        {
+#if defined COMPILER_MSVC
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return (int)index;
+#else
+            return 63 - __builtin_clzll(value);
+#endif
+        }
+
+    private:
+        friend class LatencyHistogram;
+
+        unsigned long long mCounts[NUM_BUCKET];
+        unsigned long long mCount;
+        unsigned long long mSum;
+        unsigned long long mMax;
+    };
+
+    /****************************************/
+    /*!
+        @class	LatencyHistogram
+        @brief	Single-writer histogram readable at any time
+        @note	record() must be called by one thread only.
+                snapshot() may run concurrently and sees each
+                bucket either before or after an update.
+    */
+    /****************************************/
+    class LatencyHistogram
+    {
+    public:
+        LatencyHistogram()
+        :mCount(0), mSum(0), mMax(0)
+        {
+            for(int i = 0; i < HistogramSnapshot::NUM_BUCKET; i++) mCounts[i].store(0, std::memory_order_relaxed);
+        }
+
+    public:
+        void record(unsigned long long value)
+        {
+            increment(mCounts[HistogramSnapshot::getBucketIndex(value)], 1);
+            increment(mCount, 1);
+            increment(mSum, value);
+            if(value > mMax.load(std::memory_order_relaxed)) mMax.store(value, std::memory_order_relaxed);
+        }
+
+        //! Add the current contents to out
+        void snapshot(HistogramSnapshot &out) const
+        {
+            HistogramSnapshot current;
+            for(int i = 0; i < HistogramSnapshot::NUM_BUCKET; i++) current.mCounts[i] = mCounts[i].load(std::memory_order_relaxed);
+            current.mCount = mCount.load(std::memory_order_relaxed);
+            current.mSum = mSum.load(std::memory_order_relaxed);
+            current.mMax = mMax.load(std::memory_order_relaxed);
+            out.merge(current);
+        }
+
+        //! Single-writer add, no read-modify-write instruction
+        static void increment(std::atomic<unsigned long long> &counter, unsigned long long value)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<unsigned long long> mCounts[HistogramSnapshot::NUM_BUCKET];
+        std::atomic<unsigned long long> mCount;
+        std::atomic<unsigned long long> mSum;
+        std::atomic<unsigned long long> mMax;
+    };
+
+    /****************************************/
+    /*!
+        @struct	QueueThreadStatistics
+        @brief	Snapshot of QueueThread counters
+        @note	Times are nanoseconds. waitTime is enqueue to
+                start, serviceTime is start to finish of work().
+    */
+    /****************************************/
+    struct QueueThreadStatistics
+    {
+        unsigned long long numCompleted;
+        unsigned long long numIncompleted;
+        unsigned long long numAborted;
+        unsigned long long numWork;			//!< Requests in the container when taken
+
+        unsigned long long busyTime;
+        unsigned long long idleTime;
+
+        HistogramSnapshot waitTime;
+        HistogramSnapshot serviceTime;
+
+        QueueThreadStatistics(){clear();}
+
+        void clear()
+        {
+            numCompleted = 0;
+            numIncompleted = 0;
+            numAborted = 0;
+            numWork = 0;
+            busyTime = 0;
+            idleTime = 0;
+            waitTime.clear();
+            serviceTime.clear();
+        }
+
+        void merge(const QueueThreadStatistics &other)
+        {
+            numCompleted += other.numCompleted;
+            numIncompleted += other.numIncompleted;
+            numAborted += other.numAborted;
+            numWork += other.numWork;
+            busyTime += other.busyTime;
+            idleTime += other.idleTime;
+            waitTime.merge(other.waitTime);
+            serviceTime.merge(other.serviceTime);
+        }
+    };
+
+}; //namespace SThread
+
+
+#endif //STHREAD_STATISTICS_H
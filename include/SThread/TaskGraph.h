@@ -0,0 +1,236 @@
+/******************************************************************/
+/*!
+	@file	TaskGraph.h
+	@brief	Dependency graph of requests
+	@note	Each TaskNode counts its unfinished predecessors with an
+			atomic, a node is added to the executor (QueueThread,
+			WorkerThreadPool or WorkStealingPool) by the worker which
+			finishes its last predecessor. The graph keeps its nodes
+			between runs, so a static graph is run every tick without
+			heap allocation, only a pooled completion state per run.
+	@todo
+	@bug
+
+	@author	Naoto Nakamura
+	@date	Oct. 18, 2026
+*/
+/******************************************************************/
+
+#ifndef STHREAD_TASKGRAPH_H
+#define STHREAD_TASKGRAPH_H
+
+#include "SThread/Common.h"
+
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+#include "SThread/ObjectPool.h"
+#include "SThread/InlineFunction.h"
+#include "SThread/QueueThread.h"
+
+
+namespace SThread{
+    //////////////////////////////////////////////////
+    //				forward declarations			//
+    //////////////////////////////////////////////////
+    //implemented
+    class TaskNode;
+    class FunctionTaskNode;
+    class TaskGraph;
+
+    //////////////////////////////////////////////////
+    //				class declarations				//
+    //////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @class	TaskNode
+        @brief	Request with predecessors in a TaskGraph
+        @note	Derive and override work(), or add a callable
+                to the graph. Nodes are never auto-deleted, the
+                graph owns them. Successors run even if a
+                predecessor is incompleted or aborted.
+    */
+    /****************************************/
+    class TaskNode : public WorkRequest
+    {
+        friend class TaskGraph;
+    public:
+        explicit TaskNode(int priority = PRIORITY_NORMAL)
+        :WorkRequest(priority, FALSE),
+        mGraph(NULL),
+        mNumPredecessor(0),
+        mNumPending(0)
+        {}
+
+        virtual ~TaskNode(){}
+
+    public:
+        //! This node runs before successor (both in the same graph)
+        void precede(TaskNode *successor);
+
+        //! This node runs after predecessor
+        void succeed(TaskNode *predecessor){predecessor->precede(this);}
+
+        int getNumPredecessor(){return mNumPredecessor;}
+        int getNumSuccessor(){return (int)mSuccessors.size();}
+
+    protected:
+        //! Called last by the worker, releases the successors
+        virtual void onChecked();
+
+    private:
+        TaskGraph *mGraph;
+        std::vector<TaskNode*> mSuccessors;
+        int mNumPredecessor;
+        std::atomic<int> mNumPending;		//!< Predecessors left in the current run
+    };
+
+    /****************************************/
+    /*!
+        @class	FunctionTaskNode
+        @brief	TaskNode which runs a callable
+        @note	Storage as FunctionRequest.
+    */
+    /****************************************/
+    class FunctionTaskNode : public TaskNode
+    {
+    public:
+        template <class F>
+        explicit FunctionTaskNode(F &&fn, int priority = PRIORITY_NORMAL)
+        :TaskNode(priority),
+        mFunction(std::forward<F>(fn))
+        {}
+
+        virtual ~FunctionTaskNode(){}
+
+    private:
+        virtual bool work(){
+            return mFunction();
+        }
+
+    private:
+        InlineFunction mFunction;
+    };
+
+    /****************************************/
+    /*!
+        @class	TaskGraph
+        @brief	Reusable DAG of TaskNode
+        @note	Build the graph, then run() and wait() as often
+                as needed. The roots and a cycle check are
+                computed on the first run after a change.
+                The graph must not change while it runs.
+    */
+    /****************************************/
+    class TaskGraph
+    {
+        friend class TaskNode;
+    public:
+        TaskGraph();
+        virtual ~TaskGraph();
+
+    private:
+        TaskGraph(const TaskGraph&);
+        TaskGraph &operator=(const TaskGraph&);
+
+    public:
+        //! Take ownership of node
+        TaskNode *add(TaskNode *node);
+
+        //! Add a FunctionTaskNode running fn
+        template <class F, typename std::enable_if<!std::is_convertible<F, TaskNode*>::value, int>::type = 0>
+        TaskNode *add(F &&fn, const int priority = WorkRequest::PRIORITY_NORMAL)
+        {
+            return add(new FunctionTaskNode(std::forward<F>(fn), priority));
+        }
+
+        /****************************************/
+        /*!
+            @brief	Start a run on executor
+            @note	executor is anything with
+                    addRequest(WorkRequest*, bool), it must outlive
+                    the run. Returns FALSE if the graph is running
+                    or has a cycle.
+        */
+        /****************************************/
+        template <class Executor>
+        bool run(Executor &executor)
+        {
+            return start(&executor, &submitTo<Executor>);
+        }
+
+        //! Block until the current run is finished
+        void wait();
+
+        bool isRunning(){return mRun != NULL && mRun->numRemaining.load(std::memory_order_acquire) != 0;}
+        int getNumNode(){return (int)mNodes.size();}
+        TaskNode *getNode(int index){return mNodes[index];}
+
+        //! Delete all nodes (not while running)
+        void clear();
+
+    private:
+        /****************************************/
+        /*!
+            @struct	RunState
+            @brief	Completion count of one run
+            @note	Pooled, one reference for the graph and one
+                    for the worker which finishes the last node.
+                    That worker notifies after the count reached
+                    0, when wait() may have returned and the graph
+                    may be gone, so it only touches this state.
+        */
+        /****************************************/
+        struct RunState
+        {
+            std::atomic<int> numRemaining;		//!< Nodes not finished
+            std::atomic<int> numRef;
+            void *reserved[1];					//!< ObjectPool needs two pointers
+
+            explicit RunState(const int numNode)
+            :numRemaining(numNode),
+            numRef(2)
+            {}
+
+            static RunState *create(const int numNode)
+            {
+                return new(ObjectPool<RunState>::allocate()) RunState(numNode);
+            }
+
+            void release()
+            {
+                if(numRef.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+                ObjectPool<RunState>::deallocate(this);
+            }
+        };
+
+    private:
+        template <class Executor>
+        static bool submitTo(void *executor, WorkRequest *req)
+        {
+            return static_cast<Executor*>(executor)->addRequest(req, TRUE);
+        }
+
+        bool start(void *executor, bool (*submit)(void *executor, WorkRequest *req));
+        bool prepare();
+        void dispatch(TaskNode *node);
+        void finish(TaskNode *node);
+
+    private:
+        std::vector<TaskNode*> mNodes;
+        std::vector<TaskNode*> mRoots;
+        bool mIsPrepared;				//!< mRoots is up to date
+        bool mIsAcyclic;
+
+        RunState *mRun;					//!< Current or last run, NULL before the first
+
+        void *mExecutor;
+        bool (*mSubmit)(void *executor, WorkRequest *req);
+    };
+
+}; //namespace SThread
+
+
+#endif //STHREAD_TASKGRAPH_H
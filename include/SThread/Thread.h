@@ -18,6 +18,7 @@
 #include "SThread/Common.h"
 
 #include <atomic>
+#include <chrono>
 #include <string>
 
 #include "SThread/Lock.h"
@@ -77,7 +78,7 @@ namespace SThread{
         virtual void cleanup();
 
         ThreadState getState() const {
-            return mState;
+            return mState.load();
         }
         
         ThreadHandle getHandle() const {return mDriver->mThreadHandle;}
@@ -88,6 +89,21 @@ namespace SThread{
         virtual bool shutdown();
         
         ResumeStatus join(unsigned long timeupMillSec = 0xffffffff);
+
+        template <class Rep, class Period>
+        ResumeStatus join(const std::chrono::duration<Rep, Period> &timeout){
+            return joinUntilNano(Timer::getMonotonicNanoTime() + Timer::toNanoTime(timeout));
+        }
+
+        template <class Clock, class Duration>
+        ResumeStatus joinUntil(const std::chrono::time_point<Clock, Duration> &deadline){
+            return joinUntilNano(Timer::toMonotonicNanoTime(deadline));
+        }
+
+        ResumeStatus joinUntilNano(unsigned long long deadlineNanoSec);
+
+        //! Wake node once run() has returned, FALSE if it already has
+        bool addJoinWaiter(WaitNode *node);
         
         void runContainer();
 
@@ -96,7 +112,9 @@ namespace SThread{
         }
         
 
+        //! Also the track name in traces, call before start()
         void setName(const std::string &name){mName = name;}
+        const std::string &getName() const {return mName;}
 
     protected:
         void setState(ThreadState state)
@@ -109,8 +127,9 @@ namespace SThread{
         
 
     protected:
-        std::atomic<ThreadState> mState;				//<! Thread state
-        int mPriority;					//<! Thread priority(enum ThreadPriority)
+        //on its own line, polled by the running thread; a plain atomic so subclasses keep mState.load()
+        ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) std::atomic<ThreadState> mState;	//<! Thread state
+        ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) int mPriority;	//<! Thread priority(enum ThreadPriority)
         
         int mBindIndex;
         
@@ -122,6 +141,9 @@ namespace SThread{
         ThreadDriver* mDriver;
 
         std::string mName;
+
+        SpinLock mJoinWaiterLock;
+        WaitNode *mJoinWaiters;			//<! Woken by the thread after run()
     };
 
 }; //namespace SThread
@@ -71,7 +71,8 @@ namespace SThread{
         virtual void cancelThread() = 0;
         virtual void shutdownThread() = 0;
                     
-        virtual ResumeStatus join(unsigned long timeupMillSec) = 0;
+        //! Wait for the thread until the Timer::getMonotonicNanoTime() deadline
+        virtual ResumeStatus joinUntil(unsigned long long deadlineNanoSec) = 0;
         
         Thread *getThread(){return mThread;}
       
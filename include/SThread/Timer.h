@@ -18,10 +18,22 @@
 
 #if defined OS_WINDOWS
 #include <mmsystem.h>
-#elif defined OS_MACOSX || defined OS_IPHONE
-#include <CoreFoundation/CoreFoundation.h>
-#elif defined OS_LINUX || defined OS_ANDROID
-#include <sys/time.h>
+#endif
+
+#if defined COMPILER_GCC
+#include <time.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+
+#if defined ARCHTECTURE_IA
+#   if defined COMPILER_MSVC
+#include <intrin.h>
+#   else
+#include <x86intrin.h>
+#   endif
+#define TIMER_ENABLE_TSC
 #endif
 
 
@@ -39,7 +51,10 @@ namespace SThread{
     /*!
         @class	Timer
         @brief	Timer class
-        @note
+        @note	Time stamps are CLOCK_MONOTONIC nanoseconds.
+                After enableTSC() succeeds, now() reads the
+                invariant TSC and scales it instead of calling
+                clock_gettime.
 
         @author	Naoto Nakamura
         @date	Mar. 23, 2009
@@ -47,13 +62,12 @@ namespace SThread{
     /****************************************/
     class Timer
     {
+    public:
+        static const unsigned long long MAX_WAIT_NANO_TIME = 1000000000000000000ULL;	//!< About 31 years, used for longer waits
+
     public:
         Timer()
-#if defined OS_WINDOWS
         :mBaseTime(0)
-#elif defined OS_MACOSX || defined OS_IPHONE
-        :mBaseTime(0.0)
-#endif
         {
 #if defined OS_WINDOWS
             timeBeginPeriod(1);
@@ -70,17 +84,47 @@ namespace SThread{
         inline void reset();
 
         inline unsigned int getElapsedTime();
+        inline unsigned long long getElapsedNanoTime();
         static void sleep(unsigned int milliSec);
 
+        //! Time stamp in nanoseconds for hot paths
+        static inline unsigned long long now();
+
+        //! Monotonic clock in nanoseconds, always a system call
+        static unsigned long long getMonotonicNanoTime();
+
+        //! Switch now() to the calibrated TSC if it is invariant
+        static bool enableTSC();
+        static void disableTSC(){mIsTSCEnabled.store(FALSE, std::memory_order_relaxed);}
+        static bool isTSCEnabled(){return mIsTSCEnabled.load(std::memory_order_acquire);}
+        static bool isInvariantTSC();
+
+        //! Duration in nanoseconds, clamped to [0, MAX_WAIT_NANO_TIME]
+        template <class Rep, class Period>
+        static unsigned long long toNanoTime(const std::chrono::duration<Rep, Period> &duration)
+        {
+            if(duration <= duration.zero()) return 0;
+
+            std::chrono::duration<double, std::nano> nano = duration;
+            if(nano.count() >= (double)MAX_WAIT_NANO_TIME) return MAX_WAIT_NANO_TIME;
+            return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        }
+
+        //! Time point of any clock as a getMonotonicNanoTime() deadline
+        template <class Clock, class Duration>
+        static unsigned long long toMonotonicNanoTime(const std::chrono::time_point<Clock, Duration> &timePoint)
+        {
+            return getMonotonicNanoTime() + toNanoTime(timePoint - Clock::now());
+        }
+
     private:
-#if defined OS_WINDOWS
-        unsigned int mBaseTime;
-#elif defined OS_MACOSX || defined OS_IPHONE
-        double mBaseTime;
-#elif defined OS_LINUX || defined OS_ANDROID
-        struct timeval mBaseTime;
-        struct timeval mElapsedTime;
-#endif
+        unsigned long long mBaseTime;
+
+        //the calibration is stored before mIsTSCEnabled (release), relaxed as now() reads it
+        static std::atomic<bool> mIsTSCEnabled;
+        static std::atomic<double> mNanoPerTick;
+        static std::atomic<unsigned long long> mTickBase;
+        static std::atomic<unsigned long long> mNanoBase;
 
     };
 
@@ -95,13 +139,7 @@ namespace SThread{
     /****************************************/
     inline void Timer::reset()
     {
-#if defined OS_WINDOWS
-        mBaseTime = timeGetTime();
-#elif defined OS_MACOSX || defined OS_IPHONE
-        mBaseTime = CFAbsoluteTimeGetCurrent();
-#elif defined OS_LINUX || defined OS_ANDROID
-        gettimeofday(&mBaseTime, NULL);
-#endif
+        mBaseTime = now();
     }
 
     /****************************************/
@@ -117,14 +155,42 @@ namespace SThread{
     /****************************************/
     inline unsigned int Timer::getElapsedTime()
     {
-#if defined OS_WINDOWS
-        return timeGetTime() - mBaseTime;
-#elif defined OS_MACOSX || defined OS_IPHONE
-        return (unsigned int)((CFAbsoluteTimeGetCurrent() - mBaseTime) * 1000.0);
-#elif defined OS_LINUX || defined OS_ANDROID
-        gettimeofday(&mElapsedTime, NULL);
-        return (unsigned int)(mElapsedTime.tv_sec - mBaseTime.tv_sec) % 0xffffff * 1000 + (mElapsedTime.tv_usec - mBaseTime.tv_usec) / 1000;
+        return (unsigned int)(getElapsedNanoTime() / 1000000ULL);
+    }
+
+    /****************************************/
+    /*!
+        @brief	Get elapsed time
+        @return	Elapsed time since reset() (nanosec)
+    */
+    /****************************************/
+    inline unsigned long long Timer::getElapsedNanoTime()
+    {
+        unsigned long long current = now();
+        return current > mBaseTime ? current - mBaseTime : 0;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Get time stamp
+        @note	A few nanoseconds with the TSC enabled,
+                one clock_gettime (vDSO) otherwise.
+
+        @return	Monotonic time (nanosec)
+    */
+    /****************************************/
+    inline unsigned long long Timer::now()
+    {
+#if defined TIMER_ENABLE_TSC
+        if(mIsTSCEnabled.load(std::memory_order_acquire)){
+            //another core's TSC may read a little below the base, clamp instead of wrapping
+            unsigned long long tickBase = mTickBase.load(std::memory_order_relaxed);
+            unsigned long long tick = __rdtsc();
+            unsigned long long elapsed = tick > tickBase ? tick - tickBase : 0;
+            return mNanoBase.load(std::memory_order_relaxed) + (unsigned long long)((double)elapsed * mNanoPerTick.load(std::memory_order_relaxed));
+        }
 #endif
+        return getMonotonicNanoTime();
     }
 
 
@@ -0,0 +1,91 @@
+/******************************************************************/
+/*!
+	@file	TimerThread.h
+	@brief	Thread which wakes WaitNodes at deadlines
+	@note	One thread and a binary heap of deadlines serve any
+			number of pending timers, used by the coroutine sleep
+			awaitables. Deadlines are on the
+			Timer::getMonotonicNanoTime() clock.
+	@todo
+	@bug
+
+	@author	Naoto Nakamura
+	@date	Oct. 18, 2026
+*/
+/******************************************************************/
+
+#ifndef STHREAD_TIMERTHREAD_H
+#define STHREAD_TIMERTHREAD_H
+
+#include "SThread/Common.h"
+
+#include <vector>
+
+#include "SThread/Thread.h"
+
+
+namespace SThread{
+    //////////////////////////////////////////////////
+    //				forward declarations			//
+    //////////////////////////////////////////////////
+    //implemented
+    class TimerThread;
+
+    //////////////////////////////////////////////////
+    //				class declarations				//
+    //////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @class	TimerThread
+        @brief	Deadline queue with one thread
+        @note	wake of a node runs on the timer thread, keep
+                it short (post to an executor). Nodes left at
+                shutdown are woken early.
+    */
+    /****************************************/
+    class TimerThread : public Thread
+    {
+    public:
+        explicit TimerThread(const int priority = PRIORITY_NORMAL);
+        virtual ~TimerThread(){}
+
+    public:
+        virtual void init();
+        virtual bool shutdown();
+
+        //! Wake node at the deadline, FALSE if the thread is not running
+        bool add(unsigned long long deadlineNanoSec, WaitNode *node);
+
+        int getNumTimer();
+
+    protected:
+        virtual void run();
+
+    private:
+        struct Entry
+        {
+            unsigned long long deadline;
+            unsigned long long sequence;	//!< FIFO among equal deadlines
+            WaitNode *node;
+
+            bool isBefore(const Entry &entry)const{
+                if(deadline != entry.deadline) return deadline < entry.deadline;
+                return sequence < entry.sequence;
+            }
+        };
+
+    private:
+        //! Min-heap on size_t indices, the std heaps trip -Wstrict-overflow
+        static void pushHeap(std::vector<Entry> &heap, const Entry &entry);
+        static WaitNode *popHeap(std::vector<Entry> &heap);
+
+    private:
+        Condition mTimerCondition;
+        std::vector<Entry> mTimers;		//!< Heap, guarded by mTimerCondition
+        unsigned long long mSequence;
+    };
+
+}; //namespace SThread
+
+
+#endif //STHREAD_TIMERTHREAD_H
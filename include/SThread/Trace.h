@@ -0,0 +1,256 @@
+/******************************************************************/
+/*!
+	@file	Trace.h
+	@brief	Execution trace of threads and requests
+	@note	Each thread records into its own ring buffer, the
+			oldest events are overwritten when it is full.
+			Recording is one branch when tracing is disabled.
+			The buffers are written as Chrome trace JSON
+			(chrome://tracing, ui.perfetto.dev) or as a Perfetto
+			protobuf trace. Thread::setName() is the track name.
+	@todo
+	@bug
+
+	@author	Naoto Nakamura
+	@date	Oct. 18, 2026
+*/
+/******************************************************************/
+
+#ifndef STHREAD_TRACE_H
+#define STHREAD_TRACE_H
+
+#include "SThread/Common.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <vector>
+
+#include "SThread/Timer.h"
+
+
+namespace SThread{
+    //////////////////////////////////////////////////
+    //				forward declarations			//
+    //////////////////////////////////////////////////
+    //implemented
+    struct TraceEvent;
+    class TraceBuffer;
+    class Tracer;
+
+    //////////////////////////////////////////////////
+    //				enum							//
+    //////////////////////////////////////////////////
+    enum TraceEventType{
+        TRACE_WORK_BEGIN,		//!< WorkRequest::work() starts, id is the request
+        TRACE_WORK_END,			//!< WorkRequest::work() returned, arg is the WorkState
+        TRACE_ENQUEUE,			//!< Request queued by this thread, arg is its WorkPriority
+        TRACE_WAKEUP,			//!< This thread signaled a parked consumer
+        TRACE_WAIT_BEGIN,		//!< Consumer parks waiting for a request
+        TRACE_WAIT_END,
+        TRACE_SUSPEND,			//!< Consumer stops at QueueThread::suspend()
+        TRACE_RESUME
+    };
+
+    enum TraceFormat{
+        TRACE_FORMAT_CHROME_JSON,
+        TRACE_FORMAT_PERFETTO
+    };
+
+    //////////////////////////////////////////////////
+    //				class declarations				//
+    //////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @struct	TraceEvent
+        @brief	One recorded event
+        @note	id links the enqueue of a request to its
+                execution (0 when it was queued untraced).
+    */
+    /****************************************/
+    struct TraceEvent
+    {
+        unsigned long long time;	//!< Timer::now()
+        unsigned long long id;
+        unsigned int type;			//!< enum TraceEventType
+        unsigned int arg;
+    };
+
+    /****************************************/
+    /*!
+        @class	TraceBuffer
+        @brief	Single-writer ring of TraceEvent
+        @note	Only the owning thread records. collect() can run
+                at any time: it copies the ring and drops the
+                events the writer overwrote meanwhile.
+    */
+    /****************************************/
+    class TraceBuffer
+    {
+    public:
+        static const int MAX_NAME_LENGTH = 64;
+
+    public:
+        TraceBuffer(const int index, const unsigned long capacity);
+        ~TraceBuffer();
+
+    public:
+        void record(const unsigned int type, const unsigned long long id, const unsigned int arg)
+        {
+            record(type, id, arg, Timer::now());
+        }
+
+        void record(const unsigned int type, const unsigned long long id, const unsigned int arg, const unsigned long long time)
+        {
+            unsigned long long head = mHead.load(std::memory_order_relaxed);
+            TraceEvent &event = mEvents[head & mMask];
+            event.time = time;
+            event.id = id;
+            event.type = type;
+            event.arg = arg;
+            mHead.store(head + 1, std::memory_order_release);
+        }
+
+        //! Unique per thread, never 0
+        unsigned long long nextFlowId(){return ((unsigned long long)(mIndex + 1) << 40) | ++mFlowCount;}
+
+        //! Id for a request about to be added, its event waits for endEnqueue()
+        unsigned long long beginEnqueue(const unsigned int arg)
+        {
+            unsigned long long id = nextFlowId();
+            if(mPendingArgs.empty()){
+                mPendingFlowId = id;
+                mEnqueueTime = Timer::now();
+            }
+            mPendingArgs.push_back(arg);
+            return id;
+        }
+
+        //! Record the numAdded enqueues from firstId at the begin time, drop the rest
+        void endEnqueue(const unsigned long long firstId, const int numAdded)
+        {
+            size_t first = (size_t)(firstId - mPendingFlowId);
+            size_t end = first + (size_t)numAdded;
+            for(size_t i = first; i < end && i < mPendingArgs.size(); i++){
+                record(TRACE_ENQUEUE, mPendingFlowId + i, mPendingArgs[i], mEnqueueTime);
+            }
+            mPendingArgs.clear();
+        }
+
+        void collect(std::vector<TraceEvent> &out) const;
+        void clear(){mTail.store(mHead.load(std::memory_order_acquire), std::memory_order_relaxed);}
+
+        void setName(const char *name);
+        const char *getName() const {return mName;}
+        int getIndex() const {return mIndex;}
+
+        //! Guarded by the registry lock of Tracer
+        void setDetached(){mIsDetached = TRUE;}
+        bool isDetached() const {return mIsDetached;}
+        void setFree(){mIsFree = TRUE;}
+        bool isFree() const {return mIsFree;}
+
+        //! Empty the buffer for a new thread, flow ids keep counting
+        void reuse(const unsigned long capacity);
+
+    private:
+        const int mIndex;
+        char mName[MAX_NAME_LENGTH];
+
+        TraceEvent *mEvents;
+        unsigned long long mMask;
+        unsigned long long mFlowCount;
+
+        std::vector<unsigned int> mPendingArgs;		//!< Enqueues not yet known to be added
+        unsigned long long mPendingFlowId;			//!< Id of mPendingArgs[0]
+        unsigned long long mEnqueueTime;
+
+        bool mIsDetached;		//!< The thread exited
+        bool mIsFree;			//!< Detached and flushed, ready for reuse
+
+        std::atomic<unsigned long long> mTail;		//!< Events before it are cleared
+
+        ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) std::atomic<unsigned long long> mHead;
+    };
+
+    /****************************************/
+    /*!
+        @class	Tracer
+        @brief	Process-wide switch and registry of TraceBuffer
+        @note	A buffer is attached to a thread on its first event.
+                The events of a finished thread stay until they
+                are written or cleared, then its buffer is reused
+                by the next thread which attaches. Enable before
+                the traced threads start to get every enqueue
+                linked to its execution.
+    */
+    /****************************************/
+    class Tracer
+    {
+    public:
+        static const unsigned long DEFAULT_CAPACITY = 1 << 16;	//!< Events per thread
+
+    public:
+        //! capacity is rounded up to a power of two, used for buffers created from now on
+        static void enable(const unsigned long capacity = DEFAULT_CAPACITY);
+        static void disable(){mIsEnabled.store(FALSE, std::memory_order_relaxed);}
+
+        static bool isEnabled(){return mIsEnabled.load(std::memory_order_relaxed);}
+
+        static void record(const TraceEventType type, const unsigned long long id = 0, const unsigned int arg = 0)
+        {
+            if(!isEnabled()) return;
+            TraceBuffer *buffer = getBuffer();
+            if(buffer != NULL) buffer->record((unsigned int)type, id, arg);
+        }
+
+        /****************************************/
+        /*!
+            @brief	Id the consumer refers to, 0 if untraced
+            @note	Set it on the request before the add, the
+                    request may run as soon as it is added.
+                    TRACE_ENQUEUE is recorded by endEnqueue().
+        */
+        /****************************************/
+        static unsigned long long beginEnqueue(const unsigned int arg = 0)
+        {
+            if(!isEnabled()) return 0;
+            TraceBuffer *buffer = getBuffer();
+            if(buffer == NULL) return 0;
+            return buffer->beginEnqueue(arg);
+        }
+
+        //! After the add, record numAdded enqueues from firstId (0 if it was refused)
+        static void endEnqueue(const unsigned long long firstId, const int numAdded)
+        {
+            if(firstId == 0) return;
+            TraceBuffer *buffer = getBuffer();
+            if(buffer != NULL) buffer->endEnqueue(firstId, numAdded);
+        }
+
+        //! Track name of the calling thread
+        static void setCurrentThreadName(const char *name);
+
+        //! Drop recorded events, buffers stay attached (those of exited threads are reused)
+        static void clear();
+
+        static bool write(const char *path, const TraceFormat format = TRACE_FORMAT_CHROME_JSON);
+        static bool write(FILE *fp, const TraceFormat format = TRACE_FORMAT_CHROME_JSON);
+
+    private:
+        //! NULL without thread local storage
+        static TraceBuffer *getBuffer();
+        static TraceBuffer *attachBuffer();
+        static void recycleBuffers();
+
+        static void writeChromeJson(FILE *fp);
+        static void writePerfetto(FILE *fp);
+
+    private:
+        static std::atomic<bool> mIsEnabled;
+        static unsigned long mCapacity;
+    };
+
+}; //namespace SThread
+
+
+#endif //STHREAD_TRACE_H
@@ -48,7 +48,7 @@ namespace SThread{
 
         virtual void shutdownThread();
         
-        virtual ResumeStatus join(unsigned long timeupMillSec);
+        virtual ResumeStatus joinUntil(unsigned long long deadlineNanoSec);
       
     private:
         static unsigned int __stdcall _staticRun(void *instance);
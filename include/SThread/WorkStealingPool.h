@@ -0,0 +1,295 @@
+/******************************************************************/
+/*!
+	@file	WorkStealingPool.h
+	@brief	Work-stealing thread pool
+	@note	Each worker owns a Chase-Lev deque. Requests added
+			from inside WorkRequest::work() go to the local deque,
+			other requests go to a shared injection queue.
+			Idle workers steal from randomly chosen victims.
+	@todo
+	@bug
+
+	@author	Naoto Nakamura
+	@date	Oct. 18, 2026
+*/
+/******************************************************************/
+
+#ifndef STHREAD_WORKSTEALINGPOOL_H
+#define STHREAD_WORKSTEALINGPOOL_H
+
+#include "SThread/Common.h"
+
+#include <vector>
+#include <atomic>
+
+#include "SThread/QueueThread.h"
+
+
+namespace SThread{
+    //////////////////////////////////////////////////
+    //				forward declarations			//
+    //////////////////////////////////////////////////
+    //implemented
+    class WorkStealingDeque;
+    class WorkStealingThread;
+    class WorkStealingPool;
+
+    //////////////////////////////////////////////////
+    //				class declarations				//
+    //////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @class	WorkStealingDeque
+        @brief	Bounded Chase-Lev deque
+        @note	add() and pop() are for the owner thread only
+                (LIFO end), steal() may be called from any thread
+                (FIFO end). add() returns FALSE when full.
+    */
+    /****************************************/
+    class WorkStealingDeque : public RequestContainer
+    {
+    public:
+        explicit WorkStealingDeque(unsigned long capacity = 1024)
+        :RequestContainer(),
+        mBuffer(NULL),
+        mMask(0),
+        mTop(0),
+        mBottom(0)
+        {
+            unsigned long size = 2;
+            while(size < capacity) size <<= 1;
+
+            mBuffer = new std::atomic<WorkRequest*>[size];
+            mMask = size - 1;
+            for(unsigned long i = 0; i < size; i++){
+                mBuffer[i].store(NULL, std::memory_order_relaxed);
+            }
+        }
+
+        virtual ~WorkStealingDeque(){
+            SAFE_DELETE_ARRAY(mBuffer);
+        }
+
+    public:
+        virtual bool add(WorkRequest *req)
+        {
+            long b = mBottom.load(std::memory_order_relaxed);
+            long t = mTop.load(std::memory_order_acquire);
+            if(b - t > (long)mMask) return FALSE;
+
+            mBuffer[b & mMask].store(req, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            mBottom.store(b + 1, std::memory_order_relaxed);
+            return TRUE;
+        }
+
+        virtual bool erase(WorkRequest *){return FALSE;}
+
+        virtual int getNum()
+        {
+            long t = mTop.load(std::memory_order_acquire);
+            long b = mBottom.load(std::memory_order_acquire);
+            return b > t ? (int)(b - t) : 0;
+        }
+
+        virtual void init(){}
+        virtual void cleanup(){}
+
+        virtual void clear()
+        {
+            while(pop() != NULL);
+        }
+
+        virtual WorkRequest* pop()
+        {
+            long b = mBottom.load(std::memory_order_relaxed) - 1;
+            mBottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            long t = mTop.load(std::memory_order_relaxed);
+
+            if(t > b){
+                mBottom.store(b + 1, std::memory_order_relaxed);
+                return NULL;
+            }
+
+            WorkRequest *ret = mBuffer[b & mMask].load(std::memory_order_relaxed);
+            if(t == b){
+                //last element, race against thieves
+                if(!mTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)){
+                    ret = NULL;
+                }
+                mBottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return ret;
+        }
+
+        WorkRequest* steal()
+        {
+            long t = mTop.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            long b = mBottom.load(std::memory_order_acquire);
+
+            if(t >= b) return NULL;
+
+            WorkRequest *ret = mBuffer[t & mMask].load(std::memory_order_relaxed);
+            if(!mTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)){
+                return NULL;
+            }
+            return ret;
+        }
+
+    private:
+        std::atomic<WorkRequest*> *mBuffer;
+        unsigned long mMask;
+
+        ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) std::atomic<long> mTop;		//!< Written by thieves
+        ATTRIBUTE_ALIGN(CACHE_LINE_BYTE_SIZE) std::atomic<long> mBottom;	//!< Written by the owner
+    };
+
+    /****************************************/
+    /*!
+        @class	WorkStealingThread
+        @brief	Worker owned by WorkStealingPool
+        @note	Its deque is owner-only, requests added to the
+                worker (also by post, submit and the executors
+                taking it) go through the pool, which pushes to
+                this deque only from this worker.
+    */
+    /****************************************/
+    class WorkStealingThread : public QueueThread
+    {
+        friend class WorkStealingPool;
+    public:
+        WorkStealingThread(
+                           WorkStealingPool *pool,
+                           const int index,
+                           const unsigned long dequeCapacity = 1024,
+                           const unsigned long idleTime = 0xFFFFFFFF,
+                           const int priority = PRIORITY_NORMAL,
+                           const int bindIndex = -1);
+
+        virtual ~WorkStealingThread(){}
+
+    protected:
+        virtual void run();
+        virtual WorkRequest::WorkState processNextWork();
+
+        WorkRequest* findWork();
+
+    public:
+        virtual bool shutdown();
+
+        virtual bool addRequest(WorkRequest *req, const bool resume = TRUE);
+        virtual int addRequests(WorkRequest **reqs, const int num, const bool resume = TRUE);
+
+        //! Queued requests may be stolen at any time, they cannot be erased (always FALSE)
+        virtual bool eraseRequest(WorkRequest *){return FALSE;}
+
+        //! Worker of the calling thread, NULL if it is not a worker
+        static WorkStealingThread *getCurrent();
+
+    protected:
+        WorkStealingPool *mPool;
+        WorkStealingDeque *mDeque;
+
+        int mIndex;
+        unsigned int mRandomSeed;
+    };
+
+    /****************************************/
+    /*!
+        @class	WorkStealingPool
+        @brief	Work-stealing executor for WorkRequest
+    */
+    /****************************************/
+    class WorkStealingPool
+    {
+        friend class WorkStealingThread;
+    public:
+        WorkStealingPool(
+                         const int numThread,
+                         const unsigned long dequeCapacity = 1024,
+                         const unsigned long idleTime = 0xFFFFFFFF,
+                         const int priority = PRIORITY_NORMAL);
+
+        virtual ~WorkStealingPool(){}
+
+    public:
+        virtual void init();
+        virtual void cleanup();
+
+        virtual bool start();
+        virtual bool shutdown();
+
+        virtual bool addRequest(WorkRequest *req, const bool resume = TRUE);
+        virtual int addRequests(WorkRequest **reqs, const int num, const bool resume = TRUE);
+
+        //! Queue a callable as a pooled FunctionRequest, see QueueThread::post
+        template <class F>
+        bool post(F &&fn, const int priority = WorkRequest::PRIORITY_NORMAL, const bool resume = TRUE)
+        {
+            WorkRequest *req = WorkRequest::create<FunctionRequest>(std::forward<F>(fn), priority);
+            if(addRequest(req, resume)) return TRUE;
+            WorkRequest::destroy(req);
+            return FALSE;
+        }
+
+        //! post() with a Future of the callable's result, see QueueThread::submit
+        template <class F>
+        Future<typename std::invoke_result<typename std::decay<F>::type&>::type> submit(F &&fn, const int priority = WorkRequest::PRIORITY_NORMAL, const bool resume = TRUE)
+        {
+            typedef typename std::invoke_result<typename std::decay<F>::type&>::type Result;
+
+            Promise<Result> promise;
+            Future<Result> ret = promise.getFuture();
+            post([promise = std::move(promise), fn = std::forward<F>(fn)]() mutable {promise.fulfill(fn);}, priority, resume);
+            return ret;
+        }
+
+        void clearAllRequest();
+
+        int getNumWork();
+        int getNumThread(){return (int)mThreads.size();}
+
+        void setStatisticsEnabled(const bool isEnabled){
+            mIsStatisticsEnabled = isEnabled;
+            for(size_t i = 0; i < mThreads.size(); i++) mThreads[i]->setStatisticsEnabled(isEnabled);
+        }
+
+        //! Statistics of all workers, numWork is the pool's
+        QueueThreadStatistics getStatistics();
+        WorkStealingThread *getThread(int index){return mThreads[index];}
+
+        void signalAll(){
+            mRequestCondition.lock();
+            mRequestCondition.signalAll();
+            mRequestCondition.unlock();
+        }
+
+    protected:
+        bool hasWork();
+        void waitRequest(WorkStealingThread *thread);
+        void wakeupWaiting(const bool all = FALSE);
+
+    protected:
+        Condition mRequestCondition;
+        std::atomic<int> mNumWaiting;
+
+        std::vector<WorkStealingThread*> mThreads;
+        int mNumThread;
+        int mPriority;
+        unsigned long mDequeCapacity;
+
+        QueueRequestContainer mInjectionQueue;
+
+        unsigned long mIdleTime;
+
+        bool mIsStatisticsEnabled;
+
+        std::atomic<bool> mIsQuitting;
+    };
+
+}; //namespace SThread
+
+
+#endif //STHREAD_WORKSTEALINGPOOL_H
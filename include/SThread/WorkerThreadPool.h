@@ -0,0 +1,170 @@
+/******************************************************************/
+/*!
+	@file	WorkerThreadPool.h
+	@brief	Pool of worker threads sharing one request container
+	@note	All workers consume the same container, so requests
+			are processed in the container's order (priority order
+			with WorkerRequestContainer) on any idle thread.
+	@todo
+	@bug
+
+	@author	Naoto Nakamura
+	@date	Oct. 18, 2026
+*/
+/******************************************************************/
+
+#ifndef STHREAD_WORKERTHREADPOOL_H
+#define STHREAD_WORKERTHREADPOOL_H
+
+#include "SThread/Common.h"
+
+#include <vector>
+#include <atomic>
+
+#include "SThread/QueueThread.h"
+
+
+namespace SThread{
+    //////////////////////////////////////////////////
+    //				forward declarations			//
+    //////////////////////////////////////////////////
+    //implemented
+    class WorkerThread;
+    class WorkerThreadPool;
+
+    //////////////////////////////////////////////////
+    //				class declarations				//
+    //////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @class	WorkerThread
+        @brief	Consumer thread owned by WorkerThreadPool
+        @note	Waits on the pool condition instead of
+                its own request condition.
+    */
+    /****************************************/
+    class WorkerThread : public QueueThread
+    {
+    public:
+        WorkerThread(
+                     WorkerThreadPool *pool,
+                     RequestContainer *container,
+                     const unsigned long idleTime = 0xFFFFFFFF,
+                     const int priority = PRIORITY_NORMAL,
+                     const int bindIndex = -1);
+
+        virtual ~WorkerThread(){}
+
+    protected:
+        virtual void run();
+        virtual WorkRequest::WorkState processNextWork();
+
+    public:
+        virtual bool shutdown();
+
+    protected:
+        WorkerThreadPool *mPool;
+    };
+
+    /****************************************/
+    /*!
+        @class	WorkerThreadPool
+        @brief	N worker threads over a shared request container
+        @note	The container must be safe for concurrent pop
+                (QueueRequestContainer, WorkerRequestContainer).
+    */
+    /****************************************/
+    class WorkerThreadPool
+    {
+        friend class WorkerThread;
+    public:
+        WorkerThreadPool(
+                         const int numThread,
+                         RequestContainer *container = NULL,
+                         bool isComtainerAutoDelete = TRUE,
+                         const unsigned long idleTime = 0xFFFFFFFF,
+                         const int priority = PRIORITY_NORMAL);
+
+        virtual ~WorkerThreadPool(){}
+
+    public:
+        virtual void init();
+        virtual void cleanup();
+
+        virtual bool start();
+        virtual bool shutdown();
+
+        virtual bool addRequest(WorkRequest *req, const bool resume = TRUE);
+        virtual int addRequests(WorkRequest **reqs, const int num, const bool resume = TRUE);
+
+        //! Queue a callable as a pooled FunctionRequest, see QueueThread::post
+        template <class F>
+        bool post(F &&fn, const int priority = WorkRequest::PRIORITY_NORMAL, const bool resume = TRUE)
+        {
+            WorkRequest *req = WorkRequest::create<FunctionRequest>(std::forward<F>(fn), priority);
+            if(addRequest(req, resume)) return TRUE;
+            WorkRequest::destroy(req);
+            return FALSE;
+        }
+
+        //! post() with a Future of the callable's result, see QueueThread::submit
+        template <class F>
+        Future<typename std::invoke_result<typename std::decay<F>::type&>::type> submit(F &&fn, const int priority = WorkRequest::PRIORITY_NORMAL, const bool resume = TRUE)
+        {
+            typedef typename std::invoke_result<typename std::decay<F>::type&>::type Result;
+
+            Promise<Result> promise;
+            Future<Result> ret = promise.getFuture();
+            post([promise = std::move(promise), fn = std::forward<F>(fn)]() mutable {promise.fulfill(fn);}, priority, resume);
+            return ret;
+        }
+        virtual bool eraseRequest(WorkRequest *req);
+
+        void clearAllRequest();
+
+        void setDrainBatchSize(const int num){
+            for(size_t i = 0; i < mThreads.size(); i++) mThreads[i]->setDrainBatchSize(num);
+        }
+
+        int getNumWork(){return mRequestContainer->getNum();}
+        int getNumThread(){return (int)mThreads.size();}
+
+        void setStatisticsEnabled(const bool isEnabled){
+            mIsStatisticsEnabled = isEnabled;
+            for(size_t i = 0; i < mThreads.size(); i++) mThreads[i]->setStatisticsEnabled(isEnabled);
+        }
+
+        //! Statistics of all workers, numWork is the pool's
+        QueueThreadStatistics getStatistics();
+        WorkerThread *getThread(int index){return mThreads[index];}
+
+        void signalAll(){
+            mRequestCondition.lock();
+            mRequestCondition.signalAll();
+            mRequestCondition.unlock();
+        }
+
+    protected:
+        void waitRequest(WorkerThread *thread);
+
+    protected:
+        Condition mRequestCondition;
+
+        std::vector<WorkerThread*> mThreads;
+        int mNumThread;
+        int mPriority;
+
+        RequestContainer *mRequestContainer;
+        bool mIsComtainerAutoDelete;
+
+        unsigned long mIdleTime;
+
+        bool mIsStatisticsEnabled;
+
+        std::atomic<bool> mIsQuitting;
+    };
+
+}; //namespace SThread
+
+
+#endif //STHREAD_WORKERTHREADPOOL_H
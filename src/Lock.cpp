@@ -14,16 +14,224 @@
 #include <sys/time.h>
 #endif
 
+#if defined USE_FUTEX_INTERFACE
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
 
 namespace SThread{
 
+    //////////////////////////////////////////////////////////////////////
+    //							RWLock									//
+    //////////////////////////////////////////////////////////////////////
+
+    static std::atomic<int> gNextReaderSlot(0);
+#if ENABLED_THREADLOCALSTORAGE
+    static TLS int gReaderSlot = -1;
+#endif
+
+    //static
+    int RWLock::getReaderSlot()
+    {
+#if ENABLED_THREADLOCALSTORAGE
+        if(gReaderSlot < 0){
+            gReaderSlot = gNextReaderSlot.fetch_add(1, std::memory_order_relaxed) % NUM_READER_SLOT;
+        }
+        return gReaderSlot;
+#else
+        return (int)(((size_t)pthread_self() >> 4) % NUM_READER_SLOT);
+#endif
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    //							MCSLock									//
+    //////////////////////////////////////////////////////////////////////
+
+#if ENABLED_THREADLOCALSTORAGE
+    //! Queue nodes are recycled per thread and never freed
+    static TLS MCSLock::Node *gFreeMCSNode = NULL;
+#endif
+
+    void MCSLock::lock(STHREAD_LOCK_SITE_ARG)
+    {
+#if ENABLED_THREADLOCALSTORAGE
+        Node *node = gFreeMCSNode;
+        if(node != NULL) gFreeMCSNode = node->poolNext;
+        else node = new Node();
+#else
+        Node *node = new Node();
+#endif
+
+        lock(node);
+        mOwner = node;
+    }
+
+    void MCSLock::unlock()
+    {
+        Node *node = mOwner;
+        if(node == NULL) return;
+        mOwner = NULL;
+
+        unlock(node);
+
+#if ENABLED_THREADLOCALSTORAGE
+        node->poolNext = gFreeMCSNode;
+        gFreeMCSNode = node;
+#else
+        delete node;
+#endif
+    }
+
+#if defined USE_FUTEX_INTERFACE
+    static int futexWait(std::atomic<int> *addr, int expect, const struct timespec *timeout)
+    {
+        return (int)syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAIT_PRIVATE, expect, timeout, NULL, 0);
+    }
+
+    static int futexWake(std::atomic<int> *addr, int num)
+    {
+        return (int)syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAKE_PRIVATE, num, NULL, NULL, 0);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    //							Mutex									//
+    //////////////////////////////////////////////////////////////////////
+
+    /****************************************/
+    /*!
+        @brief	Slow path of lock
+        @note	Marks the word as contended (2) and
+                sleeps until it is released.
+
+        @param	state The value seen by the failed CAS
+    */
+    /****************************************/
+    void Mutex::lockContended(int state)
+    {
+        //short spin in case the owner is about to release
+        for(int i = 0; i < 100 && state != 0; i++){
+            CPU_PAUSE();
+            state = 0;
+            if(mMutex.compare_exchange_weak(state, 1, std::memory_order_acquire)) return;
+        }
+
+        if(state != 2) state = mMutex.exchange(2, std::memory_order_acquire);
+        while(state != 0){
+            futexWait(&mMutex, 2, NULL);
+            state = mMutex.exchange(2, std::memory_order_acquire);
+        }
+    }
+
+    /****************************************/
+    /*!
+        @brief	Slow path of unlock
+        @note	Called when the word was 2, so a
+                waiter may be sleeping.
+    */
+    /****************************************/
+    void Mutex::unlockContended()
+    {
+        mMutex.store(0, std::memory_order_release);
+        futexWake(&mMutex, 1);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    //							Condition								//
+    //////////////////////////////////////////////////////////////////////
+
+    /****************************************/
+    /*!
+        @brief	Wake waiters
+        @note	The caller has bumped mSequence. A waiter
+                registers before it reads the sequence, so a
+                waiter this misses reads the new sequence and
+                does not sleep. No wake credit is kept: a
+                credit could go to a waiter which has not read
+                the sequence yet and would leave the sleepers
+                without a FUTEX_WAKE.
+    */
+    /****************************************/
+    void Condition::wake(bool isAll)
+    {
+        if(mNumWaiter.load(std::memory_order_seq_cst) <= 0) return;
+
+        futexWake(&mSequence, isAll ? 0x7fffffff : 1);
+    }
+#endif
+
     //////////////////////////////////////////////////////////////////////
     //							Condition								//
     //////////////////////////////////////////////////////////////////////
+    void Condition::addWaiter(WaitNode *node)
+    {
+        node->next = NULL;
+
+        mWaiterLock.lock();
+        if(mWaiterTail != NULL) mWaiterTail->next = node;
+        else mWaiterHead = node;
+        mWaiterTail = node;
+        mHasWaiter.store(TRUE, std::memory_order_release);
+        mWaiterLock.unlock();
+    }
+
+    /****************************************/
+    /*!
+        @brief	Wake the oldest or every asynchronous waiter
+        @note	The nodes are unlinked under mWaiterLock and
+                woken after it is released.
+    */
+    /****************************************/
+    void Condition::wakeWaiter(bool isAll)
+    {
+        mWaiterLock.lock();
+        WaitNode *node = mWaiterHead;
+        if(node == NULL){
+            mWaiterLock.unlock();
+            return;
+        }
+
+        if(isAll){
+            mWaiterHead = NULL;
+            mWaiterTail = NULL;
+        }
+        else{
+            mWaiterHead = node->next;
+            if(mWaiterHead == NULL) mWaiterTail = NULL;
+            node->next = NULL;
+        }
+        mHasWaiter.store(mWaiterHead != NULL, std::memory_order_release);
+        mWaiterLock.unlock();
+
+        while(node != NULL){
+            WaitNode *next = node->next;
+            node->wake(node);
+            node = next;
+        }
+    }
+
+    /****************************************/
+    /*!
+        @brief	Wait for a signal or the deadline
+        @note	The deadline is on the monotonic clock, so
+                wall clock steps neither stretch nor shorten it.
 
-    ResumeStatus Condition::timedwait(unsigned long timeoutMilliSec, Mutex *mutex)
+        @param	deadlineNanoSec Timer::getMonotonicNanoTime() deadline
+        @param	mutex Locked mutex released while waiting (this if NULL)
+    */
+    /****************************************/
+    ResumeStatus Condition::waitHandle(unsigned long long deadlineNanoSec, Mutex *mutex)
     {
+        unsigned long long current = Timer::getMonotonicNanoTime();
+        unsigned long long timeoutNanoSec = deadlineNanoSec > current ? deadlineNanoSec - current : 0;
+
 #if defined USE_WINDOWSTHREAD_INTERFACE
+        //milliseconds, rounded up so that the wait never ends early
+        unsigned long long timeoutMilliSec = (timeoutNanoSec + 999999ULL) / 1000000ULL;
+        if(timeoutMilliSec >= INFINITE) timeoutMilliSec = INFINITE - 1;
+
         DWORD res;
         ResumeStatus ret;
         unsigned int wake = 0;
@@ -40,16 +248,16 @@ namespace SThread{
         ::EnterCriticalSection(&mCriticalSection);
         if(mutex != NULL){
             if(mutex->isLocking())isLocking = TRUE;
-            mutex->unlock();
+            mutex->unlockHandle();
         }else{
             if(this->isLocking())isLocking = TRUE;
-            unlock();
+            unlockHandle();
         }
         ::LeaveCriticalSection(&mCriticalSection);
         
         do {
             
-            res = ::WaitForSingleObject(mSemaphore, timeoutMilliSec);
+            res = ::WaitForSingleObject(mSemaphore, (DWORD)timeoutMilliSec);
             
             ::EnterCriticalSection(&mCriticalSection);
             
@@ -81,38 +289,53 @@ namespace SThread{
         
         ::EnterCriticalSection(&mCriticalSection);
         if(isLocking){
-            if(mutex != NULL)mutex->lock();
-            else lock();
+            if(mutex != NULL)mutex->lockHandle();
+            else lockHandle();
         }
         ::LeaveCriticalSection(&mCriticalSection);
         
         return ret;
         
-#elif defined USE_PTHREAD_INTERFACE
-        
+#elif defined USE_FUTEX_INTERFACE
+
+        //futex timeouts are relative and measured on CLOCK_MONOTONIC
         struct timespec timeout;
-        struct timeval currentTime;
-        
-        gettimeofday(&currentTime, 0);
+        timeout.tv_sec = (time_t)(timeoutNanoSec / 1000000000ULL);
+        timeout.tv_nsec = (long)(timeoutNanoSec % 1000000000ULL);
 
-        timeout.tv_sec = timeoutMilliSec / 1000;
-        timeout.tv_sec += currentTime.tv_sec;
-        timeout.tv_nsec = (timeoutMilliSec % 1000) * 1000000;
-        timeout.tv_nsec += currentTime.tv_usec * 1000;
+        Mutex *locker = mutex != NULL ? mutex : this;
+        //register first, see wake()
+        mNumWaiter.fetch_add(1, std::memory_order_seq_cst);
+        int sequence = mSequence.load(std::memory_order_seq_cst);
 
-        if(timeout.tv_nsec >= 1e9){
-            timeout.tv_nsec -= 1e9;
-            timeout.tv_sec++;
-        }
+        locker->unlockHandle();
+        int err = futexWait(&mSequence, sequence, &timeout);
+        bool isTimedout = err != 0 && errno == ETIMEDOUT;
 
-        int err = 0;
+        mNumWaiter.fetch_sub(1, std::memory_order_seq_cst);
+
+        locker->lockHandle();
+
+        if(isTimedout)return RESUME_TIMEDOUT;
+        else return RESUME_SIGNALED;
+
+#elif defined USE_PTHREAD_INTERFACE
         
-        if(mutex == NULL){
-            err = pthread_cond_timedwait(&mCondition, &mMutex, &timeout);
-        }else{
-            pthread_mutex_t pMutex = mutex->getMutexHandle();
-            err = pthread_cond_timedwait(&mCondition, &pMutex, &timeout);
-        }
+        struct timespec timeout;
+        MutexHandle *handle = mutex != NULL ? mutex->getMutexHandle() : &mMutex;
+        int err = 0;
+
+#if defined OS_MACOSX || defined OS_IPHONE
+        //no pthread_condattr_setclock, the relative wait uses the monotonic clock
+        timeout.tv_sec = (time_t)(timeoutNanoSec / 1000000000ULL);
+        timeout.tv_nsec = (long)(timeoutNanoSec % 1000000000ULL);
+        err = pthread_cond_timedwait_relative_np(&mCondition, handle, &timeout);
+#else
+        (void)timeoutNanoSec;
+        timeout.tv_sec = (time_t)(deadlineNanoSec / 1000000000ULL);
+        timeout.tv_nsec = (long)(deadlineNanoSec % 1000000000ULL);
+        err = pthread_cond_timedwait(&mCondition, handle, &timeout);
+#endif
         
         //if(!isLocking())unlock();
 
@@ -0,0 +1,173 @@
+
+#include "SThread/LockProfiler.h"
+
+#include <string.h>
+#include <algorithm>
+
+#if defined COMPILER_GCC
+#include <sched.h>
+#endif
+
+namespace SThread{
+
+#if defined STHREAD_LOCK_PROFILE
+    //! Registered entries, never freed
+    static std::vector<LockProfiler::Entry*> gLockProfileEntries;
+
+    //! The profiled locks cannot guard their own registry
+    static std::atomic<bool> gLockProfileLocked(FALSE);
+
+    static void lockRegistry()
+    {
+        bool expect = FALSE;
+        while(!gLockProfileLocked.compare_exchange_weak(expect, TRUE, std::memory_order_acquire)){
+            expect = FALSE;
+#if defined COMPILER_MSVC
+            Sleep(0);
+#elif defined COMPILER_GCC
+            sched_yield();
+#endif
+        }
+    }
+
+    static void unlockRegistry()
+    {
+        gLockProfileLocked.store(FALSE, std::memory_order_release);
+    }
+
+    static bool isSameText(const char *a, const char *b)
+    {
+        if(a == b) return TRUE;
+        if(a == NULL || b == NULL) return FALSE;
+        return strcmp(a, b) == 0;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Find or register an entry
+        @note	Called on the first acquisition from a site
+                (and when a lock alternates between sites).
+    */
+    /****************************************/
+    LockProfiler::Entry *LockProfiler::getEntry(const char *name, const LockSite &site)
+    {
+        lockRegistry();
+
+        Entry *ret = NULL;
+        for(size_t i = 0; i < gLockProfileEntries.size(); i++){
+            Entry *entry = gLockProfileEntries[i];
+            if(entry->line == site.line() && isSameText(entry->name, name) &&
+               isSameText(entry->file, site.file_name()) && isSameText(entry->function, site.function_name())){
+                ret = entry;
+                break;
+            }
+        }
+
+        if(ret == NULL){
+            ret = new Entry();
+            ret->name = name;
+            ret->file = site.file_name();
+            ret->function = site.function_name();
+            ret->line = site.line();
+            ret->numAcquire.store(0, std::memory_order_relaxed);
+            ret->numContended.store(0, std::memory_order_relaxed);
+            ret->waitTime.store(0, std::memory_order_relaxed);
+            ret->maxWaitTime.store(0, std::memory_order_relaxed);
+            ret->holdTime.store(0, std::memory_order_relaxed);
+            gLockProfileEntries.push_back(ret);
+        }
+
+        unlockRegistry();
+        return ret;
+    }
+#endif
+
+    std::vector<LockProfileRecord> LockProfiler::getRecords()
+    {
+        std::vector<LockProfileRecord> ret;
+
+#if defined STHREAD_LOCK_PROFILE
+        lockRegistry();
+        for(size_t i = 0; i < gLockProfileEntries.size(); i++){
+            Entry *entry = gLockProfileEntries[i];
+
+            LockProfileRecord record;
+            record.name = entry->name != NULL ? entry->name : "";
+            record.file = entry->file;
+            record.function = entry->function;
+            record.line = entry->line;
+            record.numAcquire = entry->numAcquire.load(std::memory_order_relaxed);
+            record.numContended = entry->numContended.load(std::memory_order_relaxed);
+            record.waitTime = entry->waitTime.load(std::memory_order_relaxed);
+            record.maxWaitTime = entry->maxWaitTime.load(std::memory_order_relaxed);
+            record.holdTime = entry->holdTime.load(std::memory_order_relaxed);
+
+            if(record.numAcquire > 0) ret.push_back(record);
+        }
+        unlockRegistry();
+
+        std::sort(ret.begin(), ret.end(), [](const LockProfileRecord &a, const LockProfileRecord &b){
+            if(a.waitTime != b.waitTime) return a.waitTime > b.waitTime;
+            return a.numAcquire > b.numAcquire;
+        });
+#endif
+
+        return ret;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Print the records as a table
+        @note	Times are microseconds.
+    */
+    /****************************************/
+    void LockProfiler::report(FILE *fp)
+    {
+        if(!isEnabled()){
+            fprintf(fp, "lock profile: disabled, build with STHREAD_LOCK_PROFILE (meson -Dlock_profile=true)\n");
+            return;
+        }
+
+        std::vector<LockProfileRecord> records = getRecords();
+
+        fprintf(fp, "lock profile, sorted by total wait, times in us\n");
+        fprintf(fp, "%-40s %12s %12s %7s %12s %10s %12s   %s\n",
+                "name", "acquire", "contended", "ratio", "wait total", "wait max", "hold total", "site");
+
+        for(size_t i = 0; i < records.size(); i++){
+            const LockProfileRecord &record = records[i];
+
+            std::string file = record.file;
+            size_t slash = file.find_last_of("/\\");
+            if(slash != std::string::npos) file = file.substr(slash + 1);
+
+            fprintf(fp, "%-40s %12llu %12llu %6.1f%% %12.1f %10.1f %12.1f   %s:%u (%s)\n",
+                    record.name.empty() ? "(unnamed)" : record.name.c_str(),
+                    record.numAcquire,
+                    record.numContended,
+                    100.0 * (double)record.numContended / (double)record.numAcquire,
+                    (double)record.waitTime / 1000.0,
+                    (double)record.maxWaitTime / 1000.0,
+                    (double)record.holdTime / 1000.0,
+                    file.c_str(), record.line, record.function.c_str());
+        }
+        fflush(fp);
+    }
+
+    void LockProfiler::clear()
+    {
+#if defined STHREAD_LOCK_PROFILE
+        lockRegistry();
+        for(size_t i = 0; i < gLockProfileEntries.size(); i++){
+            Entry *entry = gLockProfileEntries[i];
+            entry->numAcquire.store(0, std::memory_order_relaxed);
+            entry->numContended.store(0, std::memory_order_relaxed);
+            entry->waitTime.store(0, std::memory_order_relaxed);
+            entry->maxWaitTime.store(0, std::memory_order_relaxed);
+            entry->holdTime.store(0, std::memory_order_relaxed);
+        }
+        unlockRegistry();
+#endif
+    }
+
+}; //namespace SThread
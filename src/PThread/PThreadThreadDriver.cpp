@@ -85,13 +85,22 @@ namespace SThread{
             rc = thread_policy_set(mach_thread, THREAD_AFFINITY_POLICY, (thread_policy_t)&policy, THREAD_AFFINITY_POLICY_COUNT);
         }
 
+        mJoinCondition.lock();
+        mJoinHandle = mThreadHandle;
+        mIsReaped = FALSE;
+        mJoinCondition.unlock();
+
         thread_resume(mach_thread);
 //#elif defined OS_LINUX
        // pthread_create_suspended_np(&mThreadHandle, NULL, _staticRun, this);
 
 #else
+        //published before the thread can clear it
+        mJoinCondition.lock();
         ::pthread_create(&mThreadHandle, NULL, _staticRun, this);
         mJoinHandle = mThreadHandle;
+        mIsReaped = FALSE;
+        mJoinCondition.unlock();
 #endif
 
     }
@@ -107,22 +116,34 @@ namespace SThread{
 
     void PThreadThreadDriver::shutdownThread()
     {
-        ::pthread_detach(mThreadHandle);
+        //a thread which was not joined releases its resources by itself
+        mJoinCondition.lock();
+        if(!mIsReaped){
+            ::pthread_detach(mThreadHandle);
+            mIsReaped = TRUE;
+        }
+        mJoinCondition.unlock();
     }
 
-    ResumeStatus PThreadThreadDriver::join(unsigned long timeupMillSec)
+    ResumeStatus PThreadThreadDriver::joinUntil(unsigned long long deadlineNanoSec)
     {
-        //void *theradReturn = NULL;
-
-        //int retval = ::pthread_join(mThreadHandle, &theradReturn);
         mJoinCondition.lock();
 
-        if (mJoinHandle == NULL){
-            mJoinCondition.unlock();
-            return RESUME_JOINED;
+        //loop, a wakeup alone does not mean the thread has ended
+        ResumeStatus ret = RESUME_JOINED;
+        while(mJoinHandle != 0){
+            if(mJoinCondition.waitUntilNano(deadlineNanoSec) == RESUME_TIMEDOUT && mJoinHandle != 0){
+                ret = RESUME_TIMEDOUT;
+                break;
+            }
         }
 
-        ResumeStatus ret = mJoinCondition.timedwait(timeupMillSec);
+        //the thread has left run() and no longer needs the lock,
+        //pthread_join returns as soon as it has exited
+        if(ret == RESUME_JOINED && !mIsReaped){
+            ::pthread_join(mThreadHandle, NULL);
+            mIsReaped = TRUE;
+        }
         mJoinCondition.unlock();
 
         return ret;
@@ -167,8 +188,7 @@ namespace SThread{
         pThread->runContainer();
 
         driver->mJoinCondition.lock();
-        Timer::sleep(1);
-        driver->mJoinHandle = NULL;
+        driver->mJoinHandle = 0;
         driver->mJoinCondition.signalAll();
         driver->mJoinCondition.unlock();
         return 0;
@@ -0,0 +1,68 @@
+#include "SThread/Parallel.h"
+
+#include "SThread/ObjectPool.h"
+
+namespace SThread{
+
+    ParallelState::ParallelState(const unsigned int numChunk, void (*run)(void *context, size_t chunk), void *context)
+    :mNextChunk(0),
+    mNumDoneChunk(0),
+    mNumRef(1),
+    mHasException(FALSE),
+    mNumChunk(numChunk),
+    mRun(run),
+    mContext(context)
+    {
+    }
+
+    ParallelState *ParallelState::create(const unsigned int numChunk, void (*run)(void *context, size_t chunk), void *context)
+    {
+        void *memory = ObjectPool<ParallelState>::allocate();
+        return new(memory) ParallelState(numChunk, run, context);
+    }
+
+    void ParallelState::release()
+    {
+        if(mNumRef.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        this->~ParallelState();
+        ObjectPool<ParallelState>::deallocate(this);
+    }
+
+    /****************************************/
+    /*!
+        @brief	Claim and run chunks
+        @note	A chunk which throws still counts as done,
+                the first exception is kept for wait().
+    */
+    /****************************************/
+    void ParallelState::work()
+    {
+        while(TRUE){
+            unsigned int chunk = mNextChunk.fetch_add(1, std::memory_order_relaxed);
+            if(chunk >= mNumChunk) return;
+
+            try{
+                mRun(mContext, chunk);
+            }
+            catch(...){
+                if(!mHasException.exchange(TRUE, std::memory_order_acq_rel)) mException = std::current_exception();
+            }
+
+            if(mNumDoneChunk.fetch_add(1, std::memory_order_acq_rel) + 1 == mNumChunk){
+                mNumDoneChunk.notify_all();
+            }
+        }
+    }
+
+    void ParallelState::wait()
+    {
+        unsigned int num = mNumDoneChunk.load(std::memory_order_acquire);
+        while(num != mNumChunk){
+            mNumDoneChunk.wait(num, std::memory_order_acquire);
+            num = mNumDoneChunk.load(std::memory_order_acquire);
+        }
+
+        if(mHasException.load(std::memory_order_acquire)) std::rethrow_exception(mException);
+    }
+
+}; //namespace SThread
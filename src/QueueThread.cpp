@@ -29,13 +29,36 @@ namespace SThread{
                              const int bindIndex
                              )
     :Thread(sharedCondition, priority, bindIndex),
+    mRequestContainer(container),
+    mIsComtainerAutoDelete(isComtainerAutoDelete),
+    mIdleNanoTime((unsigned long long)idleTime * 1000000ULL),
+    mIdlePolicy(IDLE_PARK),
+    mMaxSpinCount(DEFAULT_SPIN_COUNT),
+    mYieldCount(DEFAULT_YIELD_COUNT),
+    mDrainBatchSize(1),
+    mIsStatisticsEnabled(FALSE),
+    mRequestCondition(),
+    mIsWaiting(FALSE),
+    mNumAdding(0),
     mIsSuspended(FALSE),
     mSupendCondition(),
     mIsProcessing(FALSE),
-    mRequestContainer(container),
-    mIsComtainerAutoDelete(isComtainerAutoDelete),
-    mIdleTime(idleTime)
+    mDrainBatch(NULL),
+    mSpinBudget(DEFAULT_SPIN_COUNT),
+    mAverageArrival(0),
+    mNumPickedBySpin(0),
+    mNumPickedByYield(0),
+    mNumPickedByPark(0),
+    mNumCompleted(0),
+    mNumIncompleted(0),
+    mNumAborted(0),
+    mBusyTime(0),
+    mIdleNanoTotal(0),
+    mWaitTime(),
+    mServiceTime()
     {
+        mRequestCondition.setProfileName("QueueThread::mRequestCondition");
+        mSupendCondition.setProfileName("QueueThread::mSupendCondition");
     }
 
     void QueueThread::init()
@@ -47,6 +70,8 @@ namespace SThread{
         
         mWorkLocker = new Mutex();
         mProcessingLocker = new SpinLock();
+        mWorkLocker->setProfileName("QueueThread::mWorkLocker");
+        mProcessingLocker->setProfileName("QueueThread::mProcessingLocker");
 
         Thread::init();
     }
@@ -62,11 +87,14 @@ namespace SThread{
     /****************************************/
     void QueueThread::cleanup()
     {
+        //join the consumer first, the drain pops as its only consumer
+        shutdown();
         clearAllRequest();
         Thread::cleanup();
         
         SAFE_DELETE(mWorkLocker);
         SAFE_DELETE(mProcessingLocker);
+        SAFE_DELETE_ARRAY(mDrainBatch);
         
         if(mIsComtainerAutoDelete){
             mRequestContainer->cleanup();
@@ -90,11 +118,13 @@ namespace SThread{
         }
         
         resume();
+        mRequestCondition.lock();
         mRequestCondition.signalAll();
+        mRequestCondition.unlock();
 
-        mWorkLocker->lock();
+        //join waits for the request in progress, holding mWorkLocker
+        //here would block a consumer about to take it
         Thread::shutdown();
-        mWorkLocker->unlock();
 
         return TRUE;
     }
@@ -151,16 +181,16 @@ namespace SThread{
         int complete = 0;
 
         while(1){
-            mRequestCondition.lock();
-            if(mRequestContainer->getNum() <= 0){
-                mRequestCondition.wait(mIdleTime);
-            }
-            mRequestCondition.unlock();
+            unsigned long long idleBegin = beginIdle();
+            waitRequest();
+            endIdle(idleBegin);
 
             if(mState.load() != THREAD_RUNNING) break;
 
             if(mIsSuspended.load()){
+                Tracer::record(TRACE_SUSPEND);
                 mSupendCondition.wait();
+                Tracer::record(TRACE_RESUME);
             }
 
             
@@ -173,6 +203,155 @@ namespace SThread{
         }
     }
 
+    /****************************************/
+    /*!
+        @brief	Wait until a request is queued
+        @note	Lock-free containers are polled without
+                the condition lock; the lock is taken only
+                to go to sleep.
+    */
+    /****************************************/
+    void QueueThread::waitRequest()
+    {
+        if(mIdlePolicy == IDLE_SPIN_THEN_PARK && !mRequestContainer->hasRequest()){
+            if(spinRequest()) return;
+        }
+
+        bool isParked = FALSE;
+
+        if(!mRequestContainer->isLockFree()){
+            mRequestCondition.lock();
+            //shutdown() signals under this lock, a thread arriving later must not park
+            if(mRequestContainer->getNum() <= 0 && mState.load() == THREAD_RUNNING){
+                Tracer::record(TRACE_WAIT_BEGIN);
+                mRequestCondition.waitFor(std::chrono::nanoseconds(mIdleNanoTime));
+                Tracer::record(TRACE_WAIT_END);
+                isParked = TRUE;
+            }
+            mRequestCondition.unlock();
+        }
+        else{
+            if(mRequestContainer->getNum() > 0) return;
+
+            mRequestCondition.lock();
+            mIsWaiting->store(TRUE);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(mRequestContainer->getNum() <= 0 && mState.load() == THREAD_RUNNING){
+                Tracer::record(TRACE_WAIT_BEGIN);
+                mRequestCondition.waitFor(std::chrono::nanoseconds(mIdleNanoTime));
+                Tracer::record(TRACE_WAIT_END);
+                isParked = TRUE;
+            }
+            mIsWaiting->store(FALSE);
+            mRequestCondition.unlock();
+        }
+
+        if(isParked && mRequestContainer->hasRequest()){
+            mNumPickedByPark.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /****************************************/
+    /*!
+        @brief	Spin and yield before parking
+        @note	The spin budget follows twice the moving average
+                of the iterations it took for a request to arrive,
+                and halves whenever the thread has to park.
+                Polls hasRequest(), which reads a count without
+                the container lock.
+
+        @return	return true if a request arrived (or the thread
+                is quitting), false if the thread should park
+    */
+    /****************************************/
+    bool QueueThread::spinRequest()
+    {
+        //worked on a copy, mSpinBudget is read by getIdleStatistics()
+        int budget = mSpinBudget.load(std::memory_order_relaxed);
+
+        for(int i = 0; i < budget; i++){
+            if(mRequestContainer->hasRequest()){
+                mNumPickedBySpin.fetch_add(1, std::memory_order_relaxed);
+                mAverageArrival += (i - mAverageArrival) / 8;
+                budget = mAverageArrival * 2;
+                if(budget < 16) budget = 16;
+                if(budget > mMaxSpinCount) budget = mMaxSpinCount;
+                mSpinBudget.store(budget, std::memory_order_relaxed);
+                return TRUE;
+            }
+            if(mState.load() != THREAD_RUNNING) return TRUE;
+            CPU_PAUSE();
+        }
+
+        for(int i = 0; i < mYieldCount; i++){
+            if(mRequestContainer->hasRequest()){
+                mNumPickedByYield.fetch_add(1, std::memory_order_relaxed);
+                //arrival just after the spin phase, let the budget grow
+                mAverageArrival += (budget - mAverageArrival) / 8;
+                budget += budget / 2;
+                if(budget > mMaxSpinCount) budget = mMaxSpinCount;
+                mSpinBudget.store(budget, std::memory_order_relaxed);
+                return TRUE;
+            }
+            if(mState.load() != THREAD_RUNNING) return TRUE;
+#if defined COMPILER_MSVC
+            Sleep(0);
+#elif defined COMPILER_GCC
+            sched_yield();
+#endif
+        }
+
+        budget /= 2;
+        if(budget < 16) budget = 16;
+        mSpinBudget.store(budget, std::memory_order_relaxed);
+        return FALSE;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Select the idle policy
+        @note	Call before start().
+
+        @param	maxSpinCount Upper bound of the adaptive spin count
+        @param	yieldCount The number of yields before parking
+    */
+    /****************************************/
+    void QueueThread::setIdlePolicy(IdlePolicy policy, const int maxSpinCount, const int yieldCount)
+    {
+        mIdlePolicy = policy;
+        mMaxSpinCount = maxSpinCount > 16 ? maxSpinCount : 16;
+        mYieldCount = yieldCount > 0 ? yieldCount : 0;
+        mSpinBudget.store(mMaxSpinCount, std::memory_order_relaxed);
+        mAverageArrival = mMaxSpinCount / 2;
+    }
+
+    QueueThread::IdleStatistics QueueThread::getIdleStatistics()
+    {
+        IdleStatistics ret;
+        ret.numSpin = mNumPickedBySpin.load(std::memory_order_relaxed);
+        ret.numYield = mNumPickedByYield.load(std::memory_order_relaxed);
+        ret.numPark = mNumPickedByPark.load(std::memory_order_relaxed);
+        ret.spinBudget = mSpinBudget.load(std::memory_order_relaxed);
+        return ret;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Wake up the consumer parked in waitRequest
+        @note	Used by the lock-free path only.
+    */
+    /****************************************/
+    void QueueThread::wakeupWaiting()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(!mIsWaiting->load()) return;
+
+        Tracer::record(TRACE_WAKEUP);
+        mRequestCondition.lock();
+        mRequestCondition.signalAll();
+        mRequestCondition.unlock();
+    }
+
     /****************************************/
     /*!
         @brief	Process next task which is waiting
@@ -188,6 +367,24 @@ namespace SThread{
     {
         WorkRequest *currentRequest;
 
+        if(mDrainBatchSize > 1){
+            int num = popRequests(mDrainBatch, mDrainBatchSize);
+            if(num <= 0) return WorkRequest::WORK_VOID;
+
+            return processBatch(num);
+        }
+
+        if(mRequestContainer->isLockFree()){
+            currentRequest = mRequestContainer->pop();
+            if(currentRequest == NULL) return WorkRequest::WORK_VOID;
+
+            setProcessing(true);
+
+            WorkRequest::WorkState state = processRequest(currentRequest);
+            setProcessing(false);
+            return state;
+        }
+
         //Get next request
         mRequestCondition.lock();
 
@@ -202,12 +399,102 @@ namespace SThread{
             return WorkRequest::WORK_VOID;
         }
 
-        mProcessingLocker->lock();
-        mIsProcessing = true;
-        mProcessingLocker->unlock();
+        setProcessing(true);
         
         mRequestCondition.unlock();
-        
+
+        WorkRequest::WorkState state = processRequest(currentRequest);
+        setProcessing(false);
+        return state;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Pop up to max requests with one lock acquisition
+        @note	The processing flag is raised before the lock
+                is released when something was popped.
+
+        @return The number of popped requests
+    */
+    /****************************************/
+    int QueueThread::popRequests(WorkRequest **reqs, const int max)
+    {
+        if(mRequestContainer->isLockFree()){
+            int num = mRequestContainer->popBatch(reqs, max);
+            if(num > 0) setProcessing(true);
+            return num;
+        }
+
+        mRequestCondition.lock();
+        int num = mRequestContainer->popBatch(reqs, max);
+        if(num > 0) setProcessing(true);
+        mRequestCondition.unlock();
+
+        return num;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Run the drained batch through workBatch
+        @note
+
+        @param	num The number of requests in mDrainBatch
+        @return Processing state of the last request
+    */
+    /****************************************/
+    WorkRequest::WorkState QueueThread::processBatch(const int num)
+    {
+        WorkRequest::WorkState state = workBatch(mDrainBatch, num);
+        setProcessing(false);
+        return state;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Process a drained batch
+        @note	virtual. Override to handle the whole batch
+                at once; each request still has to go through
+                processRequest to complete its life cycle.
+
+        @return Processing state of the last request
+    */
+    /****************************************/
+    WorkRequest::WorkState QueueThread::workBatch(WorkRequest **reqs, const int num)
+    {
+        WorkRequest::WorkState state = WorkRequest::WORK_VOID;
+        for(int i = 0; i < num; i++){
+            state = processRequest(reqs[i]);
+        }
+        return state;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Set the number of requests drained per lock
+        @note	1 processes requests one by one.
+                Call before start().
+    */
+    /****************************************/
+    void QueueThread::setDrainBatchSize(const int num)
+    {
+        SAFE_DELETE_ARRAY(mDrainBatch);
+        mDrainBatchSize = num > 1 ? num : 1;
+        if(mDrainBatchSize > 1) mDrainBatch = new WorkRequest*[mDrainBatchSize];
+    }
+
+    /****************************************/
+    /*!
+        @brief	Process a request popped from the container
+        @note
+
+        @param	currentRequest Processed request
+        @return Request processing state (enum WorkRequestAbstract::WorkState)
+    */
+    /****************************************/
+    WorkRequest::WorkState QueueThread::processRequest(WorkRequest *currentRequest)
+    {
+        unsigned long long startTime = mIsStatisticsEnabled ? Timer::now() : 0;
+
         WorkRequest::WorkState state = currentRequest->getState();
         switch(state){
             case WorkRequest::WORK_NOTPROGRESS:
@@ -216,12 +503,14 @@ namespace SThread{
                     currentRequest->setState(WorkRequest::WORK_INPROGRESS);
                     currentRequest->mIsReseted = FALSE;
 
+                    Tracer::record(TRACE_WORK_BEGIN, currentRequest->mTraceId);
                     bool isOK = workRequest(currentRequest);
 
                     if(!currentRequest->isReseted()){
                         if(isOK)currentRequest->setState(WorkRequest::WORK_COMPLETED);
                         else currentRequest->setState(WorkRequest::WORK_INCOMPLETED);
                     }
+                    Tracer::record(TRACE_WORK_END, 0, (unsigned int)currentRequest->getState());
 
                     break;
                 }
@@ -232,6 +521,10 @@ namespace SThread{
         }
 
         state = currentRequest->getState();
+
+        if(startTime != 0){
+            recordStatistics(state, currentRequest->mEnqueueTime, startTime, Timer::now());
+        }
         
         Condition *cond = currentRequest->mCondition;
 
@@ -240,7 +533,7 @@ namespace SThread{
         if(currentRequest->isAutoDeletedObject()){
             currentRequest->cleanup();
             currentRequest->onChecked();
-            delete currentRequest;
+            WorkRequest::destroy(currentRequest);
             currentRequest = NULL;
         }
         else {
@@ -250,10 +543,6 @@ namespace SThread{
         if(cond != NULL){
             cond->signalAll();
         }
-        
-        mProcessingLocker->lock();
-        mIsProcessing = false;
-        mProcessingLocker->unlock();
 
         return state;
     }
@@ -263,6 +552,77 @@ namespace SThread{
         return request->work();
     }
 
+    /****************************************/
+    /*!
+        @brief	Record one processed request
+        @note	Called by the consumer only
+    */
+    /****************************************/
+    void QueueThread::recordStatistics(WorkRequest::WorkState state, unsigned long long enqueueTime, unsigned long long startTime, unsigned long long finishTime)
+    {
+        switch(state){
+            case WorkRequest::WORK_COMPLETED:
+                LatencyHistogram::increment(mNumCompleted, 1);
+                break;
+            case WorkRequest::WORK_INCOMPLETED:
+                LatencyHistogram::increment(mNumIncompleted, 1);
+                break;
+            case WorkRequest::WORK_ABORTED:
+                LatencyHistogram::increment(mNumAborted, 1);
+                return;
+            default:
+                return;
+        }
+
+        unsigned long long serviceTime = finishTime > startTime ? finishTime - startTime : 0;
+        mServiceTime.record(serviceTime);
+        LatencyHistogram::increment(mBusyTime, serviceTime);
+
+        if(enqueueTime != 0){
+            mWaitTime.record(startTime > enqueueTime ? startTime - enqueueTime : 0);
+        }
+    }
+
+    /****************************************/
+    /*!
+        @brief	Get statistics
+        @note	Counters are read one by one while the thread
+                runs, so they may be off by the request in flight.
+    */
+    /****************************************/
+    QueueThreadStatistics QueueThread::getStatistics()
+    {
+        QueueThreadStatistics ret;
+        ret.numCompleted = mNumCompleted.load(std::memory_order_relaxed);
+        ret.numIncompleted = mNumIncompleted.load(std::memory_order_relaxed);
+        ret.numAborted = mNumAborted.load(std::memory_order_relaxed);
+        ret.numWork = (unsigned long long)getNumWork();
+        ret.busyTime = mBusyTime.load(std::memory_order_relaxed);
+        ret.idleTime = mIdleNanoTotal.load(std::memory_order_relaxed);
+
+        mWaitTime.snapshot(ret.waitTime);
+        mServiceTime.snapshot(ret.serviceTime);
+        return ret;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Count a lock-free add in flight
+        @note	Counted before the state check, so either the
+                add sees THREAD_QUITTING or clearAllRequest()
+                sees it in flight and drains after its push.
+                The caller decrements mNumAdding after the push.
+    */
+    /****************************************/
+    bool QueueThread::beginLockFreeAdd()
+    {
+        mNumAdding->fetch_add(1);
+        if(mState.load() != THREAD_QUITTING) return TRUE;
+
+        mNumAdding->fetch_sub(1);
+        return FALSE;
+    }
+
     /****************************************/
     /*!
         @brief	Add new request
@@ -278,25 +638,103 @@ namespace SThread{
     /****************************************/
     bool QueueThread::addRequest(WorkRequest *req, const bool resume)
     {
+        if(mIsStatisticsEnabled) req->mEnqueueTime = Timer::now();
+        unsigned long long traceId = Tracer::beginEnqueue((unsigned int)req->getPriority());
+        req->mTraceId = traceId;
+
+        if(mRequestContainer->isLockFree()){
+            if(!beginLockFreeAdd()){
+                Tracer::endEnqueue(traceId, 0);
+                return false;
+            }
+            bool ret = mRequestContainer->add(req);
+            mNumAdding->fetch_sub(1);
+            Tracer::endEnqueue(traceId, ret ? 1 : 0);
+            if(!ret) return false;
+
+            if(resume) wakeupWaiting();
+            return true;
+        }
+
         mRequestCondition.lock();
         
         if (mState.load() == THREAD_QUITTING){
             mRequestCondition.unlock();
+            Tracer::endEnqueue(traceId, 0);
             return false;
         }
         mRequestContainer->add(req);
         
         mRequestCondition.unlock();
+        Tracer::endEnqueue(traceId, 1);
 
         if(resume) mRequestCondition.signalAll();
         return true;
     }
 
+    /****************************************/
+    /*!
+        @brief	Add requests in bulk
+        @note	The container is filled under a single
+                lock acquisition and one wakeup is issued.
+
+        @param	reqs Added requests
+        @param	num The number of requests
+        @return	The number of requests added
+    */
+    /****************************************/
+    int QueueThread::addRequests(WorkRequest **reqs, const int num, const bool resume)
+    {
+        if(num <= 0) return 0;
+
+        if(mIsStatisticsEnabled){
+            unsigned long long current = Timer::now();
+            for(int i = 0; i < num; i++) reqs[i]->mEnqueueTime = current;
+        }
+        unsigned long long traceId = 0;
+        if(Tracer::isEnabled()){
+            for(int i = 0; i < num; i++) reqs[i]->mTraceId = Tracer::beginEnqueue((unsigned int)reqs[i]->getPriority());
+            traceId = reqs[0]->mTraceId;
+        }
+
+        if(mRequestContainer->isLockFree()){
+            if(!beginLockFreeAdd()){
+                Tracer::endEnqueue(traceId, 0);
+                return 0;
+            }
+            int ret = mRequestContainer->addBatch(reqs, num);
+            mNumAdding->fetch_sub(1);
+            Tracer::endEnqueue(traceId, ret);
+
+            if(resume && ret > 0) wakeupWaiting();
+            return ret;
+        }
+
+        mRequestCondition.lock();
+
+        if (mState.load() == THREAD_QUITTING){
+            mRequestCondition.unlock();
+            Tracer::endEnqueue(traceId, 0);
+            return 0;
+        }
+        int ret = mRequestContainer->addBatch(reqs, num);
+
+        mRequestCondition.unlock();
+        Tracer::endEnqueue(traceId, ret);
+
+        if(resume && ret > 0) mRequestCondition.signalAll();
+        return ret;
+    }
+
     /****************************************/
     /*!
         @brief	Erase contained request
         @note	Object is not deleted,
-                only erase from the queue
+                only erase from the queue.
+                req must be alive: the containers read its
+                link, so a request which may have run and
+                been deleted cannot be passed. Auto-deleted
+                requests are refused for that reason.
 
         @param	req Erased request
         @return	return true if processing is valid,
@@ -308,6 +746,10 @@ namespace SThread{
     /****************************************/
     bool QueueThread::eraseRequest(WorkRequest *req)
     {
+        if(req->isAutoDeletedObject()) return FALSE;
+
+        if(mRequestContainer->isLockFree()) return mRequestContainer->erase(req);
+
         mRequestCondition.lock();
         mRequestContainer->erase(req);
         mRequestCondition.unlock();
@@ -328,12 +770,21 @@ namespace SThread{
     void QueueThread::clearAllRequest()
     {
         //mRequestCondition.lock();
-        
+
+        //lock-free adds which passed the state check before shutdown land first
+        while(mNumAdding->load() != 0){
+#if defined COMPILER_MSVC
+            Sleep(0);
+#elif defined COMPILER_GCC
+            sched_yield();
+#endif
+        }
+
         WorkRequest *req = mRequestContainer->pop();
         while(req != NULL){
             if(req->isAutoDeletedObject()){
                 req->cleanup();
-                SAFE_DELETE(req);
+                WorkRequest::destroy(req);
             }
             req = mRequestContainer->pop();
         }
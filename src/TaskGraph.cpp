@@ -0,0 +1,168 @@
+#include "SThread/TaskGraph.h"
+
+namespace SThread{
+
+    //////////////////////////////////////////////////////////////////////
+    //							TaskNode								//
+    //////////////////////////////////////////////////////////////////////
+    void TaskNode::precede(TaskNode *successor)
+    {
+        mSuccessors.push_back(successor);
+        successor->mNumPredecessor++;
+        if(mGraph != NULL) mGraph->mIsPrepared = FALSE;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Release the successors
+        @note	Called after the state is final, the worker
+                does not touch the node afterwards, so the
+                graph may be run again as soon as the last
+                node has finished.
+    */
+    /****************************************/
+    void TaskNode::onChecked()
+    {
+        WorkRequest::onChecked();
+        if(mGraph != NULL) mGraph->finish(this);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    //							TaskGraph								//
+    //////////////////////////////////////////////////////////////////////
+    TaskGraph::TaskGraph()
+    :mIsPrepared(FALSE),
+    mIsAcyclic(FALSE),
+    mRun(NULL),
+    mExecutor(NULL),
+    mSubmit(NULL)
+    {
+    }
+
+    TaskGraph::~TaskGraph()
+    {
+        wait();
+        clear();
+        if(mRun != NULL) mRun->release();
+    }
+
+    TaskNode *TaskGraph::add(TaskNode *node)
+    {
+        node->mGraph = this;
+        mNodes.push_back(node);
+        mIsPrepared = FALSE;
+        return node;
+    }
+
+    void TaskGraph::clear()
+    {
+        for(size_t i = 0; i < mNodes.size(); i++) delete mNodes[i];
+        mNodes.clear();
+        mRoots.clear();
+        mIsPrepared = FALSE;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Collect the roots and check for cycles
+        @note	Kahn's algorithm on the predecessor counts,
+                mNumPending is used as scratch.
+    */
+    /****************************************/
+    bool TaskGraph::prepare()
+    {
+        if(mIsPrepared) return mIsAcyclic;
+
+        mRoots.clear();
+        std::vector<TaskNode*> ready;
+        for(size_t i = 0; i < mNodes.size(); i++){
+            TaskNode *node = mNodes[i];
+            node->mNumPending.store(node->mNumPredecessor, std::memory_order_relaxed);
+            if(node->mNumPredecessor == 0){
+                mRoots.push_back(node);
+                ready.push_back(node);
+            }
+        }
+
+        size_t numVisited = 0;
+        while(!ready.empty()){
+            TaskNode *node = ready.back();
+            ready.pop_back();
+            numVisited++;
+
+            for(size_t i = 0; i < node->mSuccessors.size(); i++){
+                TaskNode *successor = node->mSuccessors[i];
+                if(successor->mNumPending.fetch_sub(1, std::memory_order_relaxed) == 1) ready.push_back(successor);
+            }
+        }
+
+        mIsAcyclic = numVisited == mNodes.size();
+        mIsPrepared = TRUE;
+        return mIsAcyclic;
+    }
+
+    bool TaskGraph::start(void *executor, bool (*submit)(void *executor, WorkRequest *req))
+    {
+        if(isRunning()) return FALSE;
+        if(!prepare()) return FALSE;
+        if(mNodes.empty()) return TRUE;
+
+        mExecutor = executor;
+        mSubmit = submit;
+
+        for(size_t i = 0; i < mNodes.size(); i++){
+            TaskNode *node = mNodes[i];
+            node->resetState();
+            node->mNumPending.store(node->mNumPredecessor, std::memory_order_relaxed);
+        }
+        //the submits publish the counts and states to the workers
+        if(mRun != NULL) mRun->release();
+        mRun = RunState::create((int)mNodes.size());
+
+        for(size_t i = 0; i < mRoots.size(); i++) dispatch(mRoots[i]);
+        return TRUE;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Add a ready node to the executor
+        @note	A node the executor refuses (it is shutting
+                down) is aborted and finished here, so wait()
+                still returns.
+    */
+    /****************************************/
+    void TaskGraph::dispatch(TaskNode *node)
+    {
+        if(mSubmit(mExecutor, node)) return;
+
+        node->setAbort();
+        node->onChecked();
+    }
+
+    void TaskGraph::finish(TaskNode *node)
+    {
+        for(size_t i = 0; i < node->mSuccessors.size(); i++){
+            TaskNode *successor = node->mSuccessors[i];
+            if(successor->mNumPending.fetch_sub(1, std::memory_order_acq_rel) == 1) dispatch(successor);
+        }
+
+        //the graph may be destroyed once the count is 0, see RunState
+        RunState *run = mRun;
+        if(run->numRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1){
+            run->numRemaining.notify_all();
+            run->release();
+        }
+    }
+
+    void TaskGraph::wait()
+    {
+        if(mRun == NULL) return;
+
+        int num = mRun->numRemaining.load(std::memory_order_acquire);
+        while(num != 0){
+            mRun->numRemaining.wait(num, std::memory_order_acquire);
+            num = mRun->numRemaining.load(std::memory_order_acquire);
+        }
+    }
+
+}; //namespace SThread
@@ -5,6 +5,7 @@
 
 #include "SThread/Timer.h"
 #include "SThread/Thread.h"
+#include "SThread/Trace.h"
 
 namespace SThread{
 
@@ -22,7 +23,8 @@ namespace SThread{
     mThreadCondition(sharedCondition),
     mCondiionShared(false),
     mPriority(priority),
-    mBindIndex(bindIndex)
+    mBindIndex(bindIndex),
+    mJoinWaiters(NULL)
     {
         if(sharedCondition != NULL) mCondiionShared = true;
     }
@@ -141,17 +143,55 @@ namespace SThread{
     /****************************************/
     ResumeStatus Thread::join(unsigned long timeupMillSec)
     {
-        if(mState.load() == THREAD_STOPED){
-            return RESUME_JOINED;
-        }
-        return mDriver->join(timeupMillSec);
+        return joinUntilNano(Timer::getMonotonicNanoTime() + (unsigned long long)timeupMillSec * 1000000ULL);
+    }
+
+    ResumeStatus Thread::joinUntilNano(unsigned long long deadlineNanoSec)
+    {
+        //THREAD_STOPED is set before the driver is done with the thread,
+        //the driver returns at once for a thread which is not running
+        return mDriver->joinUntil(deadlineNanoSec);
     }
 
     void Thread::runContainer()
     {
+        if(!mName.empty()) Tracer::setCurrentThreadName(mName.c_str());
+
         run();
         
         setState(THREAD_STOPED);
+
+        mJoinWaiterLock.lock();
+        WaitNode *node = mJoinWaiters;
+        mJoinWaiters = NULL;
+        mJoinWaiterLock.unlock();
+
+        while(node != NULL){
+            WaitNode *next = node->next;
+            node->wake(node);
+            node = next;
+        }
+    }
+
+    /****************************************/
+    /*!
+        @brief	Queue node to be woken after run()
+        @note	The state is checked under mJoinWaiterLock,
+                runContainer() sets it before taking the lock,
+                so a node is either queued and woken or refused.
+    */
+    /****************************************/
+    bool Thread::addJoinWaiter(WaitNode *node)
+    {
+        mJoinWaiterLock.lock();
+        if(mState.load() == THREAD_STOPED){
+            mJoinWaiterLock.unlock();
+            return FALSE;
+        }
+        node->next = mJoinWaiters;
+        mJoinWaiters = node;
+        mJoinWaiterLock.unlock();
+        return TRUE;
     }
 
     /****************************************/
@@ -172,10 +212,9 @@ namespace SThread{
             setState(THREAD_QUITTING);
         }
         
+        //returns once the thread has exited, no settling time needed
         join();
 
-        Timer::sleep(10);
-
         if(mState.load() != THREAD_STOPED){
             setState(THREAD_STOPED);
         }
@@ -4,7 +4,17 @@
 
 #include <time.h>
 
+#if defined TIMER_ENABLE_TSC && defined COMPILER_GCC
+#include <cpuid.h>
+#endif
+
 namespace SThread{
+
+    std::atomic<bool> Timer::mIsTSCEnabled(FALSE);
+    std::atomic<double> Timer::mNanoPerTick(0.0);
+    std::atomic<unsigned long long> Timer::mTickBase(0);
+    std::atomic<unsigned long long> Timer::mNanoBase(0);
+
     /****************************************/
     /*!
         @brief	Sleep
@@ -31,4 +41,85 @@ namespace SThread{
 
     }
 
+    unsigned long long Timer::getMonotonicNanoTime()
+    {
+#if defined OS_WINDOWS
+        static LARGE_INTEGER frequency = {0};
+        if(frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return (unsigned long long)(counter.QuadPart / frequency.QuadPart) * 1000000000ULL +
+            (unsigned long long)(counter.QuadPart % frequency.QuadPart) * 1000000000ULL / frequency.QuadPart;
+#elif defined COMPILER_GCC
+        struct timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return (unsigned long long)time.tv_sec * 1000000000ULL + (unsigned long long)time.tv_nsec;
+#endif
+    }
+
+    /****************************************/
+    /*!
+        @brief	Check the invariant TSC
+        @note	CPUID 0x80000007, EDX bit 8. Without it the TSC
+                rate follows frequency scaling and sleep states.
+    */
+    /****************************************/
+    bool Timer::isInvariantTSC()
+    {
+#if defined TIMER_ENABLE_TSC
+#   if defined COMPILER_MSVC
+        int info[4];
+        __cpuid(info, 0x80000000);
+        if((unsigned int)info[0] < 0x80000007) return FALSE;
+        __cpuid(info, 0x80000007);
+        return (info[3] & (1 << 8)) != 0;
+#   else
+        unsigned int eax, ebx, ecx, edx;
+        if(__get_cpuid_max(0x80000000, NULL) < 0x80000007) return FALSE;
+        if(!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return FALSE;
+        return (edx & (1 << 8)) != 0;
+#   endif
+#else
+        return FALSE;
+#endif
+    }
+
+    /****************************************/
+    /*!
+        @brief	Enable the TSC path of now()
+        @note	Calibrates the tick rate against the monotonic
+                clock for about 10 ms. Call once at startup,
+                before other threads use now().
+
+        @return	return false if the TSC is not invariant
+    */
+    /****************************************/
+    bool Timer::enableTSC()
+    {
+#if defined TIMER_ENABLE_TSC
+        if(!isInvariantTSC()) return FALSE;
+
+        static const unsigned long long CALIBRATION_TIME = 10000000ULL;
+
+        unsigned long long nanoBegin = getMonotonicNanoTime();
+        unsigned long long tickBegin = __rdtsc();
+        unsigned long long nanoEnd, tickEnd;
+        do{
+            nanoEnd = getMonotonicNanoTime();
+            tickEnd = __rdtsc();
+        }while(nanoEnd - nanoBegin < CALIBRATION_TIME);
+
+        if(tickEnd <= tickBegin) return FALSE;
+
+        mNanoPerTick.store((double)(nanoEnd - nanoBegin) / (double)(tickEnd - tickBegin), std::memory_order_relaxed);
+        mTickBase.store(tickEnd, std::memory_order_relaxed);
+        mNanoBase.store(nanoEnd, std::memory_order_relaxed);
+        mIsTSCEnabled.store(TRUE, std::memory_order_release);
+        return TRUE;
+#else
+        return FALSE;
+#endif
+    }
+
 };	// namespace SThread
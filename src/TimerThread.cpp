@@ -0,0 +1,133 @@
+#include "SThread/TimerThread.h"
+
+#include <utility>
+
+namespace SThread{
+
+    TimerThread::TimerThread(const int priority)
+    :Thread(NULL, priority),
+    mSequence(0)
+    {
+    }
+
+    void TimerThread::init()
+    {
+        mTimerCondition.setProfileName("TimerThread::mTimerCondition");
+        Thread::init();
+    }
+
+    bool TimerThread::shutdown()
+    {
+        if(mState.load() != THREAD_STOPED){
+            setState(THREAD_QUITTING);
+        }
+
+        mTimerCondition.lock();
+        mTimerCondition.signalAll();
+        mTimerCondition.unlock();
+
+        Thread::shutdown();
+
+        return TRUE;
+    }
+
+    bool TimerThread::add(unsigned long long deadlineNanoSec, WaitNode *node)
+    {
+        mTimerCondition.lock();
+        if(mState.load() != THREAD_RUNNING){
+            mTimerCondition.unlock();
+            return FALSE;
+        }
+
+        Entry entry = {deadlineNanoSec, mSequence++, node};
+        pushHeap(mTimers, entry);
+
+        //only a new earliest deadline shortens the current wait
+        if(mTimers.front().node == node) mTimerCondition.signal();
+        mTimerCondition.unlock();
+        return TRUE;
+    }
+
+    int TimerThread::getNumTimer()
+    {
+        mTimerCondition.lock();
+        int ret = (int)mTimers.size();
+        mTimerCondition.unlock();
+        return ret;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Wake nodes as their deadlines pass
+        @note	Nodes are woken without the lock, so wake may
+                add the next timer.
+    */
+    /****************************************/
+    void TimerThread::run()
+    {
+        mTimerCondition.lock();
+        while(mState.load() == THREAD_RUNNING){
+            if(mTimers.empty()){
+                mTimerCondition.waitUntilNano(Timer::getMonotonicNanoTime() + Timer::MAX_WAIT_NANO_TIME);
+                continue;
+            }
+
+            unsigned long long deadline = mTimers.front().deadline;
+            if(deadline > Timer::getMonotonicNanoTime()){
+                mTimerCondition.waitUntilNano(deadline);
+                continue;
+            }
+
+            WaitNode *node = popHeap(mTimers);
+
+            mTimerCondition.unlock();
+            node->wake(node);
+            mTimerCondition.lock();
+        }
+
+        //add() refuses nodes from here on
+        std::vector<Entry> timers;
+        timers.swap(mTimers);
+        mTimerCondition.unlock();
+
+        //woken earliest first
+        while(!timers.empty()){
+            WaitNode *node = popHeap(timers);
+            node->wake(node);
+        }
+    }
+
+    void TimerThread::pushHeap(std::vector<Entry> &heap, const Entry &entry)
+    {
+        size_t index = heap.size();
+        heap.push_back(entry);
+        while(index > 0){
+            size_t parent = (index - 1) / 2;
+            if(!heap[index].isBefore(heap[parent])) break;
+            std::swap(heap[index], heap[parent]);
+            index = parent;
+        }
+    }
+
+    WaitNode *TimerThread::popHeap(std::vector<Entry> &heap)
+    {
+        WaitNode *ret = heap.front().node;
+        heap.front() = heap.back();
+        heap.pop_back();
+
+        size_t size = heap.size();
+        size_t index = 0;
+        while(TRUE){
+            size_t earliest = index;
+            size_t left = index * 2 + 1;
+            size_t right = left + 1;
+            if(left < size && heap[left].isBefore(heap[earliest])) earliest = left;
+            if(right < size && heap[right].isBefore(heap[earliest])) earliest = right;
+            if(earliest == index) break;
+            std::swap(heap[index], heap[earliest]);
+            index = earliest;
+        }
+        return ret;
+    }
+
+}; //namespace SThread
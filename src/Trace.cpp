@@ -0,0 +1,512 @@
+
+#include "SThread/Trace.h"
+
+#include <string.h>
+#include <string>
+
+#include "SThread/Lock.h"
+#include "SThread/QueueThread.h"
+
+#if defined OS_WINDOWS
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace SThread{
+
+    std::atomic<bool> Tracer::mIsEnabled(FALSE);
+    unsigned long Tracer::mCapacity = Tracer::DEFAULT_CAPACITY;
+
+    //! Every attached buffer, in attach order
+    static std::vector<TraceBuffer*> gTraceBuffers;
+    static std::vector<TraceBuffer*> gFreeTraceBuffers;	//!< Flushed buffers of exited threads
+    static Mutex gTraceBufferLocker;
+
+#if ENABLED_THREADLOCALSTORAGE
+    static TLS TraceBuffer *gTraceBuffer = NULL;
+    static TLS char gThreadName[TraceBuffer::MAX_NAME_LENGTH] = {0};
+
+    //! Detaches the buffer of the thread when it exits
+    struct TraceBufferOwner
+    {
+        TraceBuffer *buffer;
+
+        TraceBufferOwner():buffer(NULL){}
+        ~TraceBufferOwner(){
+            gTraceBufferLocker.lock();
+            buffer->setDetached();
+            gTraceBufferLocker.unlock();
+            gTraceBuffer = NULL;
+        }
+    };
+#endif
+
+    static int getProcessId()
+    {
+#if defined OS_WINDOWS
+        return (int)_getpid();
+#else
+        return (int)getpid();
+#endif
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    //							TraceBuffer								//
+    //////////////////////////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @brief	Constructor
+        @note
+
+        @param	capacity The number of events, a power of two
+    */
+    /****************************************/
+    TraceBuffer::TraceBuffer(const int index, const unsigned long capacity)
+    :mIndex(index),
+    mEvents(new TraceEvent[capacity]),
+    mMask(capacity - 1),
+    mFlowCount(0),
+    mPendingArgs(),
+    mPendingFlowId(0),
+    mEnqueueTime(0),
+    mIsDetached(FALSE),
+    mIsFree(FALSE),
+    mTail(0),
+    mHead(0)
+    {
+        mName[0] = '\0';
+    }
+
+    TraceBuffer::~TraceBuffer()
+    {
+        SAFE_DELETE_ARRAY(mEvents);
+    }
+
+    void TraceBuffer::reuse(const unsigned long capacity)
+    {
+        if(capacity != mMask + 1){
+            SAFE_DELETE_ARRAY(mEvents);
+            mEvents = new TraceEvent[capacity];
+            mMask = capacity - 1;
+        }
+        mPendingArgs.clear();
+        mTail.store(0, std::memory_order_relaxed);
+        mHead.store(0, std::memory_order_relaxed);
+        mName[0] = '\0';
+        mIsDetached = FALSE;
+        mIsFree = FALSE;
+    }
+
+    void TraceBuffer::setName(const char *name)
+    {
+        strncpy(mName, name, MAX_NAME_LENGTH - 1);
+        mName[MAX_NAME_LENGTH - 1] = '\0';
+    }
+
+    /****************************************/
+    /*!
+        @brief	Append the recorded events to out
+        @note	The slots are copied first, then the head is read
+                again: every slot the writer may have reused since
+                (including the one it is writing) is dropped.
+    */
+    /****************************************/
+    void TraceBuffer::collect(std::vector<TraceEvent> &out) const
+    {
+        unsigned long long capacity = mMask + 1;
+        unsigned long long head = mHead.load(std::memory_order_acquire);
+        unsigned long long begin = mTail.load(std::memory_order_relaxed);
+        if(head > capacity && head - capacity > begin) begin = head - capacity;
+        if(begin >= head) return;
+
+        std::vector<TraceEvent> events;
+        events.reserve((size_t)(head - begin));
+        for(unsigned long long i = begin; i < head; i++) events.push_back(mEvents[i & mMask]);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        unsigned long long current = mHead.load(std::memory_order_relaxed);
+        unsigned long long valid = current >= capacity ? current - capacity + 1 : 0;
+
+        for(unsigned long long i = begin; i < head; i++){
+            if(i >= valid) out.push_back(events[(size_t)(i - begin)]);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    //							Tracer									//
+    //////////////////////////////////////////////////////////////////////
+    void Tracer::enable(const unsigned long capacity)
+    {
+        unsigned long size = 16;
+        while(size < capacity) size <<= 1;
+
+        gTraceBufferLocker.lock();
+        mCapacity = size;
+        gTraceBufferLocker.unlock();
+
+        mIsEnabled.store(TRUE, std::memory_order_relaxed);
+    }
+
+    TraceBuffer *Tracer::getBuffer()
+    {
+#if ENABLED_THREADLOCALSTORAGE
+        if(gTraceBuffer == NULL) gTraceBuffer = attachBuffer();
+        return gTraceBuffer;
+#else
+        return NULL;
+#endif
+    }
+
+    /****************************************/
+    /*!
+        @brief	Buffer for the calling thread
+        @note	Takes the buffer of an exited thread once its
+                events were written or cleared, so threads
+                coming and going reuse their memory. Until then
+                its events are still written.
+    */
+    /****************************************/
+    TraceBuffer *Tracer::attachBuffer()
+    {
+        gTraceBufferLocker.lock();
+        TraceBuffer *buffer;
+        if(!gFreeTraceBuffers.empty()){
+            buffer = gFreeTraceBuffers.back();
+            gFreeTraceBuffers.pop_back();
+            buffer->reuse(mCapacity);
+        }
+        else{
+            buffer = new TraceBuffer((int)gTraceBuffers.size(), mCapacity);
+            gTraceBuffers.push_back(buffer);
+        }
+        gTraceBufferLocker.unlock();
+
+#if ENABLED_THREADLOCALSTORAGE
+        static thread_local TraceBufferOwner owner;
+        owner.buffer = buffer;
+        if(gThreadName[0] != '\0') buffer->setName(gThreadName);
+#endif
+        return buffer;
+    }
+
+    //! Detached buffers are flushed, free them for reuse (locked)
+    void Tracer::recycleBuffers()
+    {
+        for(size_t i = 0; i < gTraceBuffers.size(); i++){
+            TraceBuffer *buffer = gTraceBuffers[i];
+            if(!buffer->isDetached() || buffer->isFree()) continue;
+            buffer->setFree();
+            gFreeTraceBuffers.push_back(buffer);
+        }
+    }
+
+    /****************************************/
+    /*!
+        @brief	Set the track name of the calling thread
+        @note	Called by Thread when it starts running, with
+                the name given by Thread::setName().
+    */
+    /****************************************/
+    void Tracer::setCurrentThreadName(const char *name)
+    {
+#if ENABLED_THREADLOCALSTORAGE
+        strncpy(gThreadName, name, TraceBuffer::MAX_NAME_LENGTH - 1);
+        gThreadName[TraceBuffer::MAX_NAME_LENGTH - 1] = '\0';
+
+        if(gTraceBuffer != NULL){
+            gTraceBufferLocker.lock();
+            gTraceBuffer->setName(gThreadName);
+            gTraceBufferLocker.unlock();
+        }
+#else
+        (void)name;
+#endif
+    }
+
+    void Tracer::clear()
+    {
+        gTraceBufferLocker.lock();
+        for(size_t i = 0; i < gTraceBuffers.size(); i++) gTraceBuffers[i]->clear();
+        recycleBuffers();
+        gTraceBufferLocker.unlock();
+    }
+
+    bool Tracer::write(const char *path, const TraceFormat format)
+    {
+        FILE *fp = fopen(path, format == TRACE_FORMAT_PERFETTO ? "wb" : "w");
+        if(fp == NULL) return FALSE;
+
+        bool ret = write(fp, format);
+        if(fclose(fp) != 0) ret = FALSE;
+        return ret;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Write the recorded events of every thread
+        @note	Threads may keep recording, events recorded
+                while writing may be missing. The buffers of
+                exited threads are reused afterwards.
+    */
+    /****************************************/
+    bool Tracer::write(FILE *fp, const TraceFormat format)
+    {
+        gTraceBufferLocker.lock();
+        if(format == TRACE_FORMAT_PERFETTO) writePerfetto(fp);
+        else writeChromeJson(fp);
+        recycleBuffers();
+        gTraceBufferLocker.unlock();
+
+        return ferror(fp) == 0;
+    }
+
+    static const char *getWorkStateName(const unsigned int state)
+    {
+        switch(state){
+            case WorkRequest::WORK_COMPLETED: return "completed";
+            case WorkRequest::WORK_INCOMPLETED: return "incompleted";
+            case WorkRequest::WORK_ABORTED: return "aborted";
+            default: return "unknown";
+        }
+    }
+
+    static void writeJsonString(FILE *fp, const char *text)
+    {
+        fputc('"', fp);
+        for(const char *c = text; *c != '\0'; c++){
+            if(*c == '"' || *c == '\\') fprintf(fp, "\\%c", *c);
+            else if((unsigned char)*c < 0x20) fprintf(fp, "\\u%04x", (unsigned int)(unsigned char)*c);
+            else fputc(*c, fp);
+        }
+        fputc('"', fp);
+    }
+
+    /****************************************/
+    /*!
+        @brief	Chrome trace event format
+        @note	Times are microseconds. An enqueue is linked
+                to the work slice by a flow (bind_id).
+    */
+    /****************************************/
+    void Tracer::writeChromeJson(FILE *fp)
+    {
+        int pid = getProcessId();
+        bool isFirst = TRUE;
+        std::vector<TraceEvent> events;
+
+        fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+        for(size_t i = 0; i < gTraceBuffers.size(); i++){
+            TraceBuffer *buffer = gTraceBuffers[i];
+            int tid = buffer->getIndex() + 1;
+
+            fprintf(fp, "%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":", isFirst ? "" : ",", pid, tid);
+            if(buffer->getName()[0] != '\0') writeJsonString(fp, buffer->getName());
+            else fprintf(fp, "\"thread %d\"", tid);
+            fprintf(fp, "}}");
+            isFirst = FALSE;
+
+            events.clear();
+            buffer->collect(events);
+            for(size_t j = 0; j < events.size(); j++){
+                const TraceEvent &event = events[j];
+                fprintf(fp, ",\n{\"pid\":%d,\"tid\":%d,\"ts\":%llu.%03llu,", pid, tid, event.time / 1000, event.time % 1000);
+
+                switch(event.type){
+                    case TRACE_WORK_BEGIN:
+                        fprintf(fp, "\"ph\":\"B\",\"name\":\"work\"");
+                        if(event.id != 0) fprintf(fp, ",\"bind_id\":\"0x%llx\",\"flow_in\":true", event.id);
+                        break;
+                    case TRACE_WORK_END:
+                        fprintf(fp, "\"ph\":\"E\",\"name\":\"work\",\"args\":{\"state\":\"%s\"}", getWorkStateName(event.arg));
+                        break;
+                    case TRACE_ENQUEUE:
+                        fprintf(fp, "\"ph\":\"X\",\"dur\":0,\"name\":\"enqueue\",\"args\":{\"priority\":\"0x%x\"}", event.arg);
+                        if(event.id != 0) fprintf(fp, ",\"bind_id\":\"0x%llx\",\"flow_out\":true", event.id);
+                        break;
+                    case TRACE_WAKEUP:
+                        fprintf(fp, "\"ph\":\"i\",\"s\":\"t\",\"name\":\"wakeup\"");
+                        break;
+                    case TRACE_WAIT_BEGIN:
+                        fprintf(fp, "\"ph\":\"B\",\"name\":\"wait\"");
+                        break;
+                    case TRACE_WAIT_END:
+                        fprintf(fp, "\"ph\":\"E\",\"name\":\"wait\"");
+                        break;
+                    case TRACE_SUSPEND:
+                        fprintf(fp, "\"ph\":\"B\",\"name\":\"suspended\"");
+                        break;
+                    case TRACE_RESUME:
+                        fprintf(fp, "\"ph\":\"E\",\"name\":\"suspended\"");
+                        break;
+                    default:
+                        fprintf(fp, "\"ph\":\"i\",\"s\":\"t\",\"name\":\"unknown\"");
+                        break;
+                }
+                fprintf(fp, "}");
+            }
+        }
+        fprintf(fp, "\n]}\n");
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    //							Perfetto protobuf						//
+    //////////////////////////////////////////////////////////////////////
+    //Field numbers of perfetto/trace/trace_packet.proto and track_event/*.proto
+    static const int PB_TRACE_PACKET = 1;
+
+    static const int PB_PACKET_TIMESTAMP = 8;
+    static const int PB_PACKET_SEQUENCE_ID = 10;
+    static const int PB_PACKET_TRACK_EVENT = 11;
+    static const int PB_PACKET_SEQUENCE_FLAGS = 13;
+    static const int PB_PACKET_CLOCK_ID = 58;
+    static const int PB_PACKET_TRACK_DESCRIPTOR = 60;
+
+    static const int PB_TRACK_UUID = 1;
+    static const int PB_TRACK_NAME = 2;
+    static const int PB_TRACK_THREAD = 4;
+    static const int PB_THREAD_PID = 1;
+    static const int PB_THREAD_TID = 2;
+    static const int PB_THREAD_NAME = 5;
+
+    static const int PB_EVENT_TYPE = 9;
+    static const int PB_EVENT_TRACK_UUID = 11;
+    static const int PB_EVENT_NAME = 23;
+    static const int PB_EVENT_FLOW_IDS = 47;
+    static const int PB_EVENT_TERMINATING_FLOW_IDS = 48;
+
+    static const int PB_TYPE_SLICE_BEGIN = 1;
+    static const int PB_TYPE_SLICE_END = 2;
+    static const int PB_TYPE_INSTANT = 3;
+
+    static const int PB_SEQ_INCREMENTAL_STATE_CLEARED = 1;
+#if defined OS_WINDOWS
+    static const int PB_CLOCK_ID = 6;		//BUILTIN_CLOCK_BOOTTIME, QueryPerformanceCounter counts during sleep
+#else
+    static const int PB_CLOCK_ID = 3;		//BUILTIN_CLOCK_MONOTONIC
+#endif
+
+    static void putVarint(std::string &out, unsigned long long value)
+    {
+        while(value >= 0x80){
+            out.push_back((char)((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back((char)value);
+    }
+
+    static void putVarintField(std::string &out, const int field, const unsigned long long value)
+    {
+        putVarint(out, ((unsigned long long)field << 3) | 0);
+        putVarint(out, value);
+    }
+
+    static void putFixed64Field(std::string &out, const int field, unsigned long long value)
+    {
+        putVarint(out, ((unsigned long long)field << 3) | 1);
+        for(int i = 0; i < 8; i++){
+            out.push_back((char)(value & 0xFF));
+            value >>= 8;
+        }
+    }
+
+    static void putBytesField(std::string &out, const int field, const std::string &value)
+    {
+        putVarint(out, ((unsigned long long)field << 3) | 2);
+        putVarint(out, value.size());
+        out.append(value);
+    }
+
+    static void putPacket(FILE *fp, const std::string &packet)
+    {
+        std::string field;
+        putBytesField(field, PB_TRACE_PACKET, packet);
+        fwrite(field.data(), 1, field.size(), fp);
+    }
+
+    /****************************************/
+    /*!
+        @brief	Perfetto protobuf trace
+        @note	One packet sequence and one thread track
+                per buffer; no interning, so every event
+                carries its name.
+    */
+    /****************************************/
+    void Tracer::writePerfetto(FILE *fp)
+    {
+        int pid = getProcessId();
+        std::vector<TraceEvent> events;
+
+        for(size_t i = 0; i < gTraceBuffers.size(); i++){
+            TraceBuffer *buffer = gTraceBuffers[i];
+            unsigned long long uuid = (unsigned long long)buffer->getIndex() + 1;
+
+            std::string name = buffer->getName();
+            if(name.empty()) name = "thread " + std::to_string(uuid);
+
+            std::string thread;
+            putVarintField(thread, PB_THREAD_PID, (unsigned long long)pid);
+            putVarintField(thread, PB_THREAD_TID, uuid);
+            putBytesField(thread, PB_THREAD_NAME, name);
+
+            std::string track;
+            putVarintField(track, PB_TRACK_UUID, uuid);
+            putBytesField(track, PB_TRACK_NAME, name);
+            putBytesField(track, PB_TRACK_THREAD, thread);
+
+            std::string packet;
+            putVarintField(packet, PB_PACKET_SEQUENCE_ID, uuid);
+            putVarintField(packet, PB_PACKET_SEQUENCE_FLAGS, PB_SEQ_INCREMENTAL_STATE_CLEARED);
+            putBytesField(packet, PB_PACKET_TRACK_DESCRIPTOR, track);
+            putPacket(fp, packet);
+
+            events.clear();
+            buffer->collect(events);
+            for(size_t j = 0; j < events.size(); j++){
+                const TraceEvent &event = events[j];
+
+                std::string trackEvent;
+                putVarintField(trackEvent, PB_EVENT_TRACK_UUID, uuid);
+                switch(event.type){
+                    case TRACE_WORK_BEGIN:
+                        putVarintField(trackEvent, PB_EVENT_TYPE, PB_TYPE_SLICE_BEGIN);
+                        putBytesField(trackEvent, PB_EVENT_NAME, "work");
+                        if(event.id != 0) putFixed64Field(trackEvent, PB_EVENT_TERMINATING_FLOW_IDS, event.id);
+                        break;
+                    case TRACE_WORK_END:
+                    case TRACE_WAIT_END:
+                    case TRACE_RESUME:
+                        putVarintField(trackEvent, PB_EVENT_TYPE, PB_TYPE_SLICE_END);
+                        break;
+                    case TRACE_ENQUEUE:
+                        putVarintField(trackEvent, PB_EVENT_TYPE, PB_TYPE_INSTANT);
+                        putBytesField(trackEvent, PB_EVENT_NAME, "enqueue");
+                        if(event.id != 0) putFixed64Field(trackEvent, PB_EVENT_FLOW_IDS, event.id);
+                        break;
+                    case TRACE_WAKEUP:
+                        putVarintField(trackEvent, PB_EVENT_TYPE, PB_TYPE_INSTANT);
+                        putBytesField(trackEvent, PB_EVENT_NAME, "wakeup");
+                        break;
+                    case TRACE_WAIT_BEGIN:
+                        putVarintField(trackEvent, PB_EVENT_TYPE, PB_TYPE_SLICE_BEGIN);
+                        putBytesField(trackEvent, PB_EVENT_NAME, "wait");
+                        break;
+                    case TRACE_SUSPEND:
+                        putVarintField(trackEvent, PB_EVENT_TYPE, PB_TYPE_SLICE_BEGIN);
+                        putBytesField(trackEvent, PB_EVENT_NAME, "suspended");
+                        break;
+                    default:
+                        continue;
+                }
+
+                packet.clear();
+                putVarintField(packet, PB_PACKET_TIMESTAMP, event.time);
+                putVarintField(packet, PB_PACKET_CLOCK_ID, PB_CLOCK_ID);
+                putVarintField(packet, PB_PACKET_SEQUENCE_ID, uuid);
+                putBytesField(packet, PB_PACKET_TRACK_EVENT, trackEvent);
+                putPacket(fp, packet);
+            }
+        }
+    }
+
+}; //namespace SThread
@@ -60,18 +60,23 @@ namespace SThread{
        mThreadHandle = NULL;
     }
     
-    ResumeStatus W32ThreadDriver::join(unsigned long timeupMillSec)
+    ResumeStatus W32ThreadDriver::joinUntil(unsigned long long deadlineNanoSec)
     {
-        //if (mThread->getState() == Thread::THREAD_STOPED) return RESUME_JOINED;
-
         mJoinCondition.lock();
 
-        if (mJoinHandle == NULL){
-            mJoinCondition.unlock();
-            return RESUME_JOINED;
+        //loop, a wakeup alone does not mean the thread has ended
+        ResumeStatus ret = RESUME_JOINED;
+        while(mJoinHandle != NULL){
+            if(mJoinCondition.waitUntilNano(deadlineNanoSec) == RESUME_TIMEDOUT && mJoinHandle != NULL){
+                ret = RESUME_TIMEDOUT;
+                break;
+            }
         }
 
-        ResumeStatus ret = mJoinCondition.timedwait(timeupMillSec);
+        //the thread has left run(), wait for its exit
+        if(ret == RESUME_JOINED && mThreadHandle != NULL){
+            ::WaitForSingleObject(mThreadHandle, INFINITE);
+        }
         mJoinCondition.unlock();
 
         return ret;
@@ -85,7 +90,6 @@ namespace SThread{
         thread->runContainer();
         
         driver->mJoinCondition.lock();
-        Timer::sleep(1);
         driver->mJoinHandle = NULL;
         driver->mJoinCondition.signalAll();
         driver->mJoinCondition.unlock();
@@ -0,0 +1,387 @@
+
+#include "SThread/WorkStealingPool.h"
+
+namespace SThread{
+
+#if ENABLED_THREADLOCALSTORAGE
+    static TLS WorkStealingThread *gCurrentWorker = NULL;
+#endif
+
+    //////////////////////////////////////////////////////////////////////
+    //							WorkStealingThread						//
+    //////////////////////////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @brief	Constructor
+        @note	The local deque is the request container
+                of this thread and is deleted with it.
+    */
+    /****************************************/
+    WorkStealingThread::WorkStealingThread(
+                                           WorkStealingPool *pool,
+                                           const int index,
+                                           const unsigned long dequeCapacity,
+                                           const unsigned long idleTime,
+                                           const int priority,
+                                           const int bindIndex
+                                           )
+    :QueueThread(new WorkStealingDeque(dequeCapacity), TRUE, idleTime, NULL, priority, bindIndex),
+    mPool(pool),
+    mIndex(index),
+    mRandomSeed((unsigned int)index * 2654435761u + 1)
+    {
+        mDeque = static_cast<WorkStealingDeque*>(mRequestContainer);
+    }
+
+    WorkStealingThread *WorkStealingThread::getCurrent()
+    {
+#if ENABLED_THREADLOCALSTORAGE
+        return gCurrentWorker;
+#else
+        return NULL;
+#endif
+    }
+
+    /****************************************/
+    /*!
+        @brief	Shutdown
+        @note	Wake the pool condition so that
+                this thread leaves its wait.
+    */
+    /****************************************/
+    bool WorkStealingThread::shutdown()
+    {
+        if (mState.load() != THREAD_STOPED) {
+            setState(THREAD_QUITTING);
+        }
+        mPool->signalAll();
+
+        return QueueThread::shutdown();
+    }
+
+    /****************************************/
+    /*!
+        @brief	Add new request
+        @note	Forwarded to the pool, which pushes to this
+                deque only when called by this worker, other
+                threads go to the injection queue.
+    */
+    /****************************************/
+    bool WorkStealingThread::addRequest(WorkRequest *req, const bool resume)
+    {
+        return mPool->addRequest(req, resume);
+    }
+
+    int WorkStealingThread::addRequests(WorkRequest **reqs, const int num, const bool resume)
+    {
+        return mPool->addRequests(reqs, num, resume);
+    }
+
+    /****************************************/
+    /*!
+        @brief	Function Block which process the thread
+        @note	virtual
+    */
+    /****************************************/
+    void WorkStealingThread::run()
+    {
+#if ENABLED_THREADLOCALSTORAGE
+        gCurrentWorker = this;
+#endif
+
+        while(1){
+            if(mState.load() != THREAD_RUNNING) break;
+
+            if(mIsSuspended.load()){
+                Tracer::record(TRACE_SUSPEND);
+                mSupendCondition.wait();
+                Tracer::record(TRACE_RESUME);
+            }
+
+            if(mState.load() != THREAD_RUNNING) break;
+            mWorkLocker->lock();
+            WorkRequest::WorkState state = processNextWork();
+            mWorkLocker->unlock();
+
+            if(state == WorkRequest::WORK_VOID){
+                unsigned long long idleBegin = beginIdle();
+                mPool->waitRequest(this);
+                endIdle(idleBegin);
+            }
+        }
+
+#if ENABLED_THREADLOCALSTORAGE
+        gCurrentWorker = NULL;
+#endif
+    }
+
+    /****************************************/
+    /*!
+        @brief	Find next request
+        @note	Local deque, injection queue, then
+                steal from random victims.
+    */
+    /****************************************/
+    WorkRequest* WorkStealingThread::findWork()
+    {
+        WorkRequest *req = mDeque->pop();
+        if(req != NULL) return req;
+
+        req = mPool->mInjectionQueue.pop();
+        if(req != NULL) return req;
+
+        int numThread = (int)mPool->mThreads.size();
+        if(numThread <= 1) return NULL;
+
+        for(int i = 0; i < numThread; i++){
+            //xorshift
+            mRandomSeed ^= mRandomSeed << 13;
+            mRandomSeed ^= mRandomSeed >> 17;
+            mRandomSeed ^= mRandomSeed << 5;
+
+            int victim = (int)(mRandomSeed % (unsigned int)numThread);
+            if(victim == mIndex) continue;
+
+            req = mPool->mThreads[victim]->mDeque->steal();
+            if(req != NULL) return req;
+        }
+        return NULL;
+    }
+
+    WorkRequest::WorkState WorkStealingThread::processNextWork()
+    {
+        WorkRequest *currentRequest = findWork();
+        if(currentRequest == NULL) return WorkRequest::WORK_VOID;
+
+        setProcessing(true);
+
+        WorkRequest::WorkState state = processRequest(currentRequest);
+        setProcessing(false);
+        return state;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    //							WorkStealingPool						//
+    //////////////////////////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @brief	Constructor
+        @note
+
+        @param	numThread The number of worker threads
+        @param	dequeCapacity Capacity of each local deque
+    */
+    /****************************************/
+    WorkStealingPool::WorkStealingPool(
+                                       const int numThread,
+                                       const unsigned long dequeCapacity,
+                                       const unsigned long idleTime,
+                                       const int priority
+                                       )
+    :mRequestCondition(),
+    mNumWaiting(0),
+    mThreads(),
+    mNumThread(numThread),
+    mPriority(priority),
+    mDequeCapacity(dequeCapacity),
+    mInjectionQueue(),
+    mIdleTime(idleTime),
+    mIsStatisticsEnabled(FALSE),
+    mIsQuitting(FALSE)
+    {
+        mRequestCondition.setProfileName("WorkStealingPool::mRequestCondition");
+    }
+
+    void WorkStealingPool::init()
+    {
+        for(int i = 0; i < mNumThread; i++){
+            WorkStealingThread *thread = new WorkStealingThread(this, i, mDequeCapacity, mIdleTime, mPriority);
+            thread->init();
+            thread->setName("stealing worker " + std::to_string(i));
+            thread->setStatisticsEnabled(mIsStatisticsEnabled);
+            mThreads.push_back(thread);
+        }
+    }
+
+    /****************************************/
+    /*!
+        @brief	Cleanup
+        @note	Workers are stopped before the remaining
+                requests are cleared.
+    */
+    /****************************************/
+    void WorkStealingPool::cleanup()
+    {
+        shutdown();
+        clearAllRequest();
+
+        for(size_t i = 0; i < mThreads.size(); i++){
+            mThreads[i]->cleanup();
+            delete mThreads[i];
+        }
+        mThreads.clear();
+    }
+
+    bool WorkStealingPool::start()
+    {
+        mIsQuitting.store(FALSE);
+
+        bool ret = TRUE;
+        for(size_t i = 0; i < mThreads.size(); i++){
+            if(!mThreads[i]->start()) ret = FALSE;
+        }
+        return ret;
+    }
+
+    bool WorkStealingPool::shutdown()
+    {
+        mIsQuitting.store(TRUE);
+
+        for(size_t i = 0; i < mThreads.size(); i++){
+            mThreads[i]->shutdown();
+        }
+        return TRUE;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Add new request
+        @note	Called from a worker of this pool, the request
+                goes to its local deque, otherwise to the
+                injection queue.
+
+        @param	req Added request
+        @return	return true if processing is valid,
+                else return false
+    */
+    /****************************************/
+    bool WorkStealingPool::addRequest(WorkRequest *req, const bool resume)
+    {
+        if (mIsQuitting.load()) return false;
+
+        if(mIsStatisticsEnabled) req->mEnqueueTime = Timer::now();
+        unsigned long long traceId = Tracer::beginEnqueue((unsigned int)req->getPriority());
+        req->mTraceId = traceId;
+
+        WorkStealingThread *current = WorkStealingThread::getCurrent();
+        if(current == NULL || current->mPool != this || !current->mDeque->add(req)){
+            mInjectionQueue.add(req);
+        }
+        Tracer::endEnqueue(traceId, 1);
+
+        if(resume) wakeupWaiting();
+        return true;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Add requests in bulk
+        @note	Batches always go to the injection queue
+                under one lock and wake all waiting workers.
+
+        @return	The number of requests added
+    */
+    /****************************************/
+    int WorkStealingPool::addRequests(WorkRequest **reqs, const int num, const bool resume)
+    {
+        if (num <= 0 || mIsQuitting.load()) return 0;
+
+        if(mIsStatisticsEnabled){
+            unsigned long long current = Timer::now();
+            for(int i = 0; i < num; i++) reqs[i]->mEnqueueTime = current;
+        }
+        unsigned long long traceId = 0;
+        if(Tracer::isEnabled()){
+            for(int i = 0; i < num; i++) reqs[i]->mTraceId = Tracer::beginEnqueue((unsigned int)reqs[i]->getPriority());
+            traceId = reqs[0]->mTraceId;
+        }
+
+        int ret = mInjectionQueue.addBatch(reqs, num);
+        Tracer::endEnqueue(traceId, ret);
+
+        if(resume) wakeupWaiting(ret > 1);
+        return ret;
+    }
+
+    int WorkStealingPool::getNumWork()
+    {
+        int ret = mInjectionQueue.getNum();
+        for(size_t i = 0; i < mThreads.size(); i++){
+            ret += mThreads[i]->mDeque->getNum();
+        }
+        return ret;
+    }
+
+    QueueThreadStatistics WorkStealingPool::getStatistics()
+    {
+        QueueThreadStatistics ret;
+        for(size_t i = 0; i < mThreads.size(); i++){
+            ret.merge(mThreads[i]->getStatistics());
+        }
+        ret.numWork = (unsigned long long)getNumWork();
+        return ret;
+    }
+
+    bool WorkStealingPool::hasWork()
+    {
+        if(mInjectionQueue.getNum() > 0) return TRUE;
+        for(size_t i = 0; i < mThreads.size(); i++){
+            if(mThreads[i]->mDeque->getNum() > 0) return TRUE;
+        }
+        return FALSE;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Park a worker which found no request
+        @note	mNumWaiting is published before the final
+                check, so a concurrent addRequest either sees
+                the waiter or its request is seen here.
+    */
+    /****************************************/
+    void WorkStealingPool::waitRequest(WorkStealingThread *thread)
+    {
+        mRequestCondition.lock();
+        mNumWaiting.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(!hasWork() && thread->getState() == Thread::THREAD_RUNNING){
+            Tracer::record(TRACE_WAIT_BEGIN);
+            mRequestCondition.wait(mIdleTime);
+            Tracer::record(TRACE_WAIT_END);
+        }
+        mNumWaiting.fetch_sub(1);
+        mRequestCondition.unlock();
+    }
+
+    void WorkStealingPool::wakeupWaiting(const bool all)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(mNumWaiting.load() <= 0) return;
+
+        Tracer::record(TRACE_WAKEUP);
+        mRequestCondition.lock();
+        if(all) mRequestCondition.signalAll();
+        else mRequestCondition.signal();
+        mRequestCondition.unlock();
+    }
+
+    /****************************************/
+    /*!
+        @brief	Clear the injection queue
+        @note	Local deques are cleared by their threads' cleanup.
+    */
+    /****************************************/
+    void WorkStealingPool::clearAllRequest()
+    {
+        WorkRequest *req = mInjectionQueue.pop();
+        while(req != NULL){
+            if(req->isAutoDeletedObject()){
+                req->cleanup();
+                WorkRequest::destroy(req);
+            }
+            req = mInjectionQueue.pop();
+        }
+        mInjectionQueue.clear();
+    }
+
+}; //namespace SThread
@@ -0,0 +1,329 @@
+
+#include "SThread/WorkerThreadPool.h"
+
+namespace SThread{
+
+    //////////////////////////////////////////////////////////////////////
+    //							WorkerThread							//
+    //////////////////////////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @brief	Constructor
+        @note	The container is owned by the pool
+    */
+    /****************************************/
+    WorkerThread::WorkerThread(
+                               WorkerThreadPool *pool,
+                               RequestContainer *container,
+                               const unsigned long idleTime,
+                               const int priority,
+                               const int bindIndex
+                               )
+    :QueueThread(container, FALSE, idleTime, NULL, priority, bindIndex),
+    mPool(pool)
+    {
+    }
+
+    /****************************************/
+    /*!
+        @brief	Shutdown
+        @note	Wake the pool condition so that
+                this thread leaves its wait.
+    */
+    /****************************************/
+    bool WorkerThread::shutdown()
+    {
+        if (mState.load() != THREAD_STOPED) {
+            setState(THREAD_QUITTING);
+        }
+        mPool->signalAll();
+
+        return QueueThread::shutdown();
+    }
+
+    /****************************************/
+    /*!
+        @brief	Function Block which process the thread
+        @note	virtual
+    */
+    /****************************************/
+    void WorkerThread::run()
+    {
+        while(1){
+            unsigned long long idleBegin = beginIdle();
+            mPool->waitRequest(this);
+            endIdle(idleBegin);
+
+            if(mState.load() != THREAD_RUNNING) break;
+
+            if(mIsSuspended.load()){
+                Tracer::record(TRACE_SUSPEND);
+                mSupendCondition.wait();
+                Tracer::record(TRACE_RESUME);
+            }
+
+            if(mState.load() != THREAD_RUNNING) break;
+            mWorkLocker->lock();
+            processNextWork();
+            mWorkLocker->unlock();
+
+            if(mState.load() != THREAD_RUNNING) break;
+        }
+    }
+
+    /****************************************/
+    /*!
+        @brief	Process next task which is waiting
+        @note	The shared container is locked by itself,
+                so the pool condition is not held here.
+
+        @return Request processing state (enum WorkRequestAbstract::WorkState)
+    */
+    /****************************************/
+    WorkRequest::WorkState WorkerThread::processNextWork()
+    {
+        if(mDrainBatchSize > 1){
+            int num = mRequestContainer->popBatch(mDrainBatch, mDrainBatchSize);
+            if(num <= 0) return WorkRequest::WORK_VOID;
+
+            setProcessing(true);
+            return processBatch(num);
+        }
+
+        WorkRequest *currentRequest = mRequestContainer->pop();
+        if(currentRequest == NULL) return WorkRequest::WORK_VOID;
+
+        setProcessing(true);
+
+        WorkRequest::WorkState state = processRequest(currentRequest);
+        setProcessing(false);
+        return state;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    //							WorkerThreadPool						//
+    //////////////////////////////////////////////////////////////////////
+    /****************************************/
+    /*!
+        @brief	Constructor
+        @note
+
+        @param	numThread The number of worker threads
+        @param	container Shared container (WorkerRequestContainer if NULL)
+    */
+    /****************************************/
+    WorkerThreadPool::WorkerThreadPool(
+                                       const int numThread,
+                                       RequestContainer *container,
+                                       bool isComtainerAutoDelete,
+                                       const unsigned long idleTime,
+                                       const int priority
+                                       )
+    :mRequestCondition(),
+    mThreads(),
+    mNumThread(numThread),
+    mPriority(priority),
+    mRequestContainer(container),
+    mIsComtainerAutoDelete(isComtainerAutoDelete),
+    mIdleTime(idleTime),
+    mIsStatisticsEnabled(FALSE),
+    mIsQuitting(FALSE)
+    {
+        mRequestCondition.setProfileName("WorkerThreadPool::mRequestCondition");
+    }
+
+    void WorkerThreadPool::init()
+    {
+        if(mRequestContainer == NULL){
+            mRequestContainer = new WorkerRequestContainer();
+            mRequestContainer->init();
+        }
+
+        for(int i = 0; i < mNumThread; i++){
+            WorkerThread *thread = new WorkerThread(this, mRequestContainer, mIdleTime, mPriority);
+            thread->init();
+            thread->setName("worker " + std::to_string(i));
+            thread->setStatisticsEnabled(mIsStatisticsEnabled);
+            mThreads.push_back(thread);
+        }
+    }
+
+    /****************************************/
+    /*!
+        @brief	Cleanup
+        @note	Workers are stopped before the remaining
+                requests are cleared.
+    */
+    /****************************************/
+    void WorkerThreadPool::cleanup()
+    {
+        shutdown();
+        clearAllRequest();
+
+        for(size_t i = 0; i < mThreads.size(); i++){
+            mThreads[i]->cleanup();
+            delete mThreads[i];
+        }
+        mThreads.clear();
+
+        if(mIsComtainerAutoDelete){
+            mRequestContainer->cleanup();
+            SAFE_DELETE(mRequestContainer);
+        }
+    }
+
+    bool WorkerThreadPool::start()
+    {
+        mIsQuitting.store(FALSE);
+
+        bool ret = TRUE;
+        for(size_t i = 0; i < mThreads.size(); i++){
+            if(!mThreads[i]->start()) ret = FALSE;
+        }
+        return ret;
+    }
+
+    bool WorkerThreadPool::shutdown()
+    {
+        mIsQuitting.store(TRUE);
+
+        for(size_t i = 0; i < mThreads.size(); i++){
+            mThreads[i]->shutdown();
+        }
+        return TRUE;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Wait until a request is queued
+        @note	Called by workers
+    */
+    /****************************************/
+    void WorkerThreadPool::waitRequest(WorkerThread *thread)
+    {
+        mRequestCondition.lock();
+        if(mRequestContainer->getNum() <= 0 && thread->getState() == Thread::THREAD_RUNNING){
+            Tracer::record(TRACE_WAIT_BEGIN);
+            mRequestCondition.wait(mIdleTime);
+            Tracer::record(TRACE_WAIT_END);
+        }
+        mRequestCondition.unlock();
+    }
+
+    /****************************************/
+    /*!
+        @brief	Add new request
+        @note	Only one worker is woken per request
+
+        @param	req Added request
+        @return	return true if processing is valid,
+                else return false
+    */
+    /****************************************/
+    bool WorkerThreadPool::addRequest(WorkRequest *req, const bool resume)
+    {
+        if(mIsStatisticsEnabled) req->mEnqueueTime = Timer::now();
+        unsigned long long traceId = Tracer::beginEnqueue((unsigned int)req->getPriority());
+        req->mTraceId = traceId;
+
+        mRequestCondition.lock();
+
+        if (mIsQuitting.load()){
+            mRequestCondition.unlock();
+            Tracer::endEnqueue(traceId, 0);
+            return false;
+        }
+        mRequestContainer->add(req);
+
+        mRequestCondition.unlock();
+        Tracer::endEnqueue(traceId, 1);
+
+        if(resume) mRequestCondition.signal();
+        return true;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Add requests in bulk
+        @note	One lock acquisition; a single request wakes
+                one worker, a batch wakes all of them.
+
+        @return	The number of requests added
+    */
+    /****************************************/
+    int WorkerThreadPool::addRequests(WorkRequest **reqs, const int num, const bool resume)
+    {
+        if(num <= 0) return 0;
+
+        if(mIsStatisticsEnabled){
+            unsigned long long current = Timer::now();
+            for(int i = 0; i < num; i++) reqs[i]->mEnqueueTime = current;
+        }
+        unsigned long long traceId = 0;
+        if(Tracer::isEnabled()){
+            for(int i = 0; i < num; i++) reqs[i]->mTraceId = Tracer::beginEnqueue((unsigned int)reqs[i]->getPriority());
+            traceId = reqs[0]->mTraceId;
+        }
+
+        mRequestCondition.lock();
+
+        if (mIsQuitting.load()){
+            mRequestCondition.unlock();
+            Tracer::endEnqueue(traceId, 0);
+            return 0;
+        }
+        int ret = mRequestContainer->addBatch(reqs, num);
+
+        mRequestCondition.unlock();
+        Tracer::endEnqueue(traceId, ret);
+
+        if(resume){
+            if(ret == 1) mRequestCondition.signal();
+            else if(ret > 1) mRequestCondition.signalAll();
+        }
+        return ret;
+    }
+
+    //! req must be alive, auto-deleted requests are refused, see QueueThread::eraseRequest
+    bool WorkerThreadPool::eraseRequest(WorkRequest *req)
+    {
+        if(req->isAutoDeletedObject()) return FALSE;
+
+        mRequestCondition.lock();
+        bool ret = mRequestContainer->erase(req);
+        mRequestCondition.unlock();
+
+        return ret;
+    }
+
+    QueueThreadStatistics WorkerThreadPool::getStatistics()
+    {
+        QueueThreadStatistics ret;
+        for(size_t i = 0; i < mThreads.size(); i++){
+            ret.merge(mThreads[i]->getStatistics());
+        }
+        ret.numWork = (unsigned long long)getNumWork();
+        return ret;
+    }
+
+    /****************************************/
+    /*!
+        @brief	Clear all queue.
+        @note	In this method, objects	which
+                auto delete flag is true are deleted
+    */
+    /****************************************/
+    void WorkerThreadPool::clearAllRequest()
+    {
+        WorkRequest *req = mRequestContainer->pop();
+        while(req != NULL){
+            if(req->isAutoDeletedObject()){
+                req->cleanup();
+                WorkRequest::destroy(req);
+            }
+            req = mRequestContainer->pop();
+        }
+        mRequestContainer->clear();
+    }
+
+}; //namespace SThread